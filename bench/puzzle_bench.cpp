@@ -0,0 +1,927 @@
+/**
+    CS591-W1 Final Project
+    puzzle_bench.cpp
+    Purpose: Microbenchmarks for the search routines on a synthetic voxelized sphere, and cross-checks of their shortcuts.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <list>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <algorithm>
+#include <cmath>
+#include "../include/CompFab.h"
+#include "../include/ExtractPartitions.h"
+#include "../include/ScratchGrid.h"
+#include "../include/VoxelSearch.h"
+#include "../include/RemainderOracle.h"
+#include "../include/BitVolume.h"
+#include "../include/BlockForest.h"
+#include "../include/ComponentLabels.h"
+#include "../include/AccessibilityEngine.h"
+#include "../include/AccessibilityScorer.h"
+#include "../include/StencilKernel.h"
+#include "../include/ScorePrefix.h"
+#include "../include/WeightSampler.h"
+#include "../include/GridTransaction.h"
+
+bool accessSort(VoxelPair i, VoxelPair j);
+bool voxelSortSorter(VoxelSort i, VoxelSort j);
+bool checkPieceConnectivity(CompFab::VoxelGrid * voxel_list, const Piece & piece, int pieceId);
+extern RemainderOracle * g_remainderOracle;
+
+/**
+    Builds a solid sphere of unassigned voxels with a few random holes, keeping only what is
+    connected to its center, as a voxelized model would be.
+
+    @param dim The dimension of the grid.
+    @return The grid.
+*/
+static CompFab::VoxelGrid * makeSphere(int dim) {
+    CompFab::VoxelGrid *grid = new CompFab::VoxelGrid(CompFab::Vec3(0, 0, 0), dim, dim, dim, 1.0);
+    double c = (dim - 1)/2.0;
+    double r = dim/2.0 - 1;
+    std::srand(7);
+    for (int i = 0; i < dim; i++) {
+        for (int j = 0; j < dim; j++) {
+            for (int k = 0; k < dim; k++) {
+                double d = (i - c)*(i - c) + (j - c)*(j - c) + (k - c)*(k - c);
+                if (d <= r*r && std::rand() % 20 != 0) {
+                    grid->isInside(i, j, k) = 1;
+                }
+            }
+        }
+    }
+    ScratchLease visited(grid->m_size);
+    IndexQueue & queue = visited->m_queue;
+    unsigned int center = voxelIndex(grid, Voxel(dim/2, dim/2, dim/2));
+    grid->m_insideArray[center] = 1;
+    visited->mark(center);
+    queue.push(center);
+    while (!queue.empty()) {
+        Voxel current = voxelAt(grid, queue.front());
+        queue.pop();
+        forEachNeighbor(grid, current, 1, [&](const Voxel & next, unsigned int index) {
+            if (visited->testAndMark(index)) {
+                queue.push(index);
+            }
+        });
+    }
+    for (unsigned int i = 0; i < grid->m_size; i++) {
+        if (!visited->marked(i)) {
+            grid->m_insideArray[i] = 0;
+        }
+    }
+    return grid;
+}
+
+/**
+    bfs as it was with a std::list queue of voxels, for comparison.
+*/
+static std::vector<VoxelPair> listBfs(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, Voxel seed, Voxel normal, int nb_one, int nb_two) {
+    std::vector<VoxelPair> potentials;
+    int nx = voxel_list->m_dimX;
+    int ny = voxel_list->m_dimY;
+    int nz = voxel_list->m_dimZ;
+    ScratchLease visited(nx*ny*nz);
+    std::list<Voxel> queue;
+    Neighbors neighbors;
+    Voxel blockee;
+    Voxel blocker;
+    visited->mark(seed.z*(nx*ny) + seed.y*ny + seed.x);
+    queue.push_back(seed);
+    while (!queue.empty() && potentials.size() < nb_one) {
+        blockee = queue.front();
+        blocker = blockee + normal;
+        if (blocker.x < 0 || blocker.x >= nx || blocker.y < 0 || blocker.y >= ny || blocker.z < 0 || blocker.z >= nz) {
+            ;
+        } else if (voxel_list->isInside(blocker.x, blocker.y, blocker.z) == 1 && blocker != seed) {
+            potentials.push_back(VoxelPair(blocker, scores->score(blocker.x, blocker.y, blocker.z), blockee, scores->score(blockee.x, blockee.y, blockee.z)));
+        }
+        queue.pop_front();
+        neighbors = getNeighbors(blockee, voxel_list, 1);
+        for (int i = 0; i < neighbors.size(); i++) {
+            if ( !visited->marked(neighbors.index(i)) ) {
+                visited->mark(neighbors.index(i));
+                queue.push_back(neighbors[i]);
+            }
+        }
+    }
+    std::sort (potentials.begin(), potentials.end(), accessSort);
+    if (potentials.size() > nb_two) {
+        potentials.erase(potentials.begin() + nb_two, potentials.end());
+    }
+    return potentials;
+}
+
+/**
+    partitionPiece as it was, checking the whole rest of the piece for every voxel it takes.
+*/
+static Piece legacyPartition(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, const Piece & piece, int numPartition, int pieceSize) {
+    std::vector<VoxelSort> sorted;
+    for (int i = 0; i < piece.size(); i++) {
+        sorted.push_back(VoxelSort(piece[i], scores->score(piece[i].x, piece[i].y, piece[i].z)));
+    }
+    std::sort (sorted.begin(), sorted.end(), voxelSortSorter);
+    Piece byAccess;
+    for (int i = 0; i < sorted.size(); i++) {
+        byAccess.insert(sorted[i].voxel);
+    }
+    Piece partition;
+    ScratchLease visited(voxel_list->m_size);
+    IndexQueue & queue = visited->m_queue;
+    Neighbors neighbors;
+    visited->mark(voxelIndex(voxel_list, byAccess[0]));
+    queue.push(voxelIndex(voxel_list, byAccess[0]));
+    while ( !queue.empty() && partition.size() < pieceSize ) {
+        Voxel current = voxelAt(voxel_list, queue.front());
+        queue.pop();
+        neighbors = getNeighbors(current, voxel_list, numPartition);
+        for (int i = 0; i < neighbors.size(); i++) {
+            if ( !visited->marked(neighbors.index(i)) ) {
+                partition.insert(neighbors[i]);
+                for (int j = 0; j< partition.size(); j++) {
+                    setVoxelLabel(voxel_list, partition[j], 0);
+                }
+                bool connected = checkPieceConnectivity(voxel_list, byAccess, numPartition);
+                for (int j = 0; j< partition.size(); j++) {
+                    setVoxelLabel(voxel_list, partition[j], numPartition);
+                }
+                if (!connected) {
+                    partition.erase(neighbors[i]);
+                }
+                visited->mark(neighbors.index(i));
+                queue.push(neighbors.index(i));
+            }
+        }
+    }
+    return partition;
+}
+
+/**
+    expandPiece as it was, finding and scoring every candidate column again after each one it adds.
+*/
+static Piece legacyExpand(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, Piece key, std::vector<Voxel> anchors, int num_voxels, Voxel normal) {
+    ScratchLease visited(voxel_list->m_size);
+    Voxel neg_dir = Voxel(-normal.x, -normal.y, -normal.z);
+    std::vector<Voxel> column;
+    for (int i = 0; i < anchors.size(); i++) {
+        collectAlongRay(voxel_list, anchors[i], neg_dir, 1, &column);
+    }
+    for (int i = 0; i < column.size(); i++) {
+        visited->mark(voxelIndex(voxel_list, column[i]));
+    }
+    for (int i = 0; i < key.size(); i++) {
+        visited->mark(voxelIndex(voxel_list, key[i]));
+    }
+    int count = key.size();
+    std::vector<Voxel> candidates;
+    std::vector<double> access_sums;
+    std::vector<bool> fits;
+    WeightSampler sampler;
+    Piece tempPiece;
+    GridTransaction trial(voxel_list);
+    while (count < num_voxels) {
+        for (int i = 0; i < key.size(); i++) {
+            Neighbors neighbors = getNeighbors(key[i], voxel_list, 1);
+            for (int j = 0; j < neighbors.size(); j++) {
+                if (!visited->marked(neighbors.index(j))) {
+                    visited->mark(neighbors.index(j));
+                    candidates.push_back(neighbors[j]);
+                }
+            }
+        }
+        if (candidates.size() == 0) {
+            break;
+        }
+        for (int i = 0; i < candidates.size(); i++) {
+            tempPiece.clear();
+            visited->unmark(voxelIndex(voxel_list, candidates[i]));
+            int total = count;
+            column.clear();
+            collectAlongRay(voxel_list, candidates[i], normal, 1, &column);
+            for (int j = 0; j < column.size(); j++) {
+                if (!visited->marked(voxelIndex(voxel_list, column[j]))) {
+                    tempPiece.insert(column[j]);
+                    total++;
+                }
+            }
+            for (int j = 0; j < tempPiece.size(); j++) {
+                trial.include(tempPiece[j]);
+            }
+            if (trial.components() > 1) {
+                tempPiece = ensurePieceConnectivity(voxel_list, tempPiece, normal);
+            }
+            trial.rollback();
+            double sum = 0;
+            for (int j = 0; j < tempPiece.size(); j++) {
+                sum += scores->score(tempPiece[j].x, tempPiece[j].y, tempPiece[j].z);
+            }
+            access_sums.push_back(std::pow(sum, -2.0));
+            fits.push_back(total <= num_voxels);
+        }
+        bool anyFits = std::find(fits.begin(), fits.end(), true) != fits.end();
+        for (int i = 0; i < access_sums.size(); i++) {
+            if (anyFits && !fits[i]) {
+                access_sums[i] = 0;
+            }
+        }
+        sampler.assign(access_sums);
+        int choice = sampler.draw((double) std::rand() / (RAND_MAX));
+        column.clear();
+        collectAlongRay(voxel_list, candidates[choice], normal, 1, &column);
+        for (int i = 0; i < column.size(); i++) {
+            if (!visited->marked(voxelIndex(voxel_list, column[i]))) {
+                key.insert(column[i]);
+                visited->mark(voxelIndex(voxel_list, column[i]));
+            }
+        }
+        for (int i = 0; i < key.size(); i++) {
+            visited->mark(voxelIndex(voxel_list, key[i]));
+        }
+        candidates.clear();
+        access_sums.clear();
+        fits.clear();
+        count = key.size();
+    }
+    return key;
+}
+
+/**
+    Scores accessibility the way accessibilityScores did before scoring was iterative: one
+    recursive call and one new grid per level, less the leak of the level below.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param alpha A double used as a param for how to generate the scores.
+    @param recurse How many layers of recursion to perform in score generation.
+    @param pieceId The id of the piece we are scoring.
+    @return The scores.
+*/
+static AccessibilityGrid * legacyScores( CompFab::VoxelGrid * voxel_list, double alpha, unsigned int recurse, int pieceId) {
+    int nx = voxel_list->m_dimX;
+    int ny = voxel_list->m_dimY;
+    int nz = voxel_list->m_dimZ;
+    CompFab::Vec3 start = CompFab::Vec3(0.0, 0.0, 0.0);
+    AccessibilityGrid * scores = new AccessibilityGrid(start, nx, ny, nz);
+    if (recurse == 0) {
+        for (int i = 0; i < nx; i++) {
+            for (int j = 0; j < ny; j++) {
+                for (int k = 0; k < nz; k++) {
+                    scores->score(i, j, k) = getNeighbors(Voxel(i, j, k), voxel_list, pieceId).size();
+                }
+            }
+        }
+    } else {
+        double current_score;
+        double multiplier = pow(alpha, recurse);
+        AccessibilityGrid * old_scores = legacyScores( voxel_list, alpha, recurse-1, pieceId);
+        const double *old_array = old_scores->m_scoreArray;
+        for (int i = 0; i < nx; i++) {
+            for (int j = 0; j < ny; j++) {
+                for (int k = 0; k < nz; k++) {
+                    current_score = 0;
+                    forEachNeighbor(voxel_list, Voxel(i, j, k), pieceId, [&current_score, old_array](const Voxel & neighbor, unsigned int index) {
+                        current_score += old_array[index];
+                    });
+                    current_score *= multiplier;
+                    current_score += old_scores->score(i,j,k);
+                    scores->score(i,j,k) = current_score;
+                }
+            }
+        }
+        delete old_scores;
+    }
+    return scores;
+}
+
+/**
+    The breadth first remainder check verifyPiece used to run, with either queue.
+
+    @param useList true for a std::list of voxels, false for the ring buffer of indices.
+    @return The number of voxels reached.
+*/
+static unsigned int remainderBfs(CompFab::VoxelGrid * voxel_list, const Piece & piece, bool useList) {
+    ScratchLease visited(voxel_list->m_size);
+    for (int i = 0; i < piece.size(); i++) {
+        visited->mark(voxelIndex(voxel_list, piece[i]));
+    }
+    Voxel start(-1, -1, -1);
+    for (unsigned int i = 0; i < voxel_list->m_size && start.x == -1; i++) {
+        if (voxel_list->m_insideArray[i] == 1 && !visited->marked(i)) {
+            start = voxelAt(voxel_list, i);
+        }
+    }
+    unsigned int reached = 1;
+    visited->mark(voxelIndex(voxel_list, start));
+    if (useList) {
+        std::list<Voxel> queue;
+        Neighbors neighbors;
+        queue.push_back(start);
+        while (!queue.empty()) {
+            Voxel current = queue.front();
+            queue.pop_front();
+            neighbors = getNeighbors(current, voxel_list, 1);
+            for (int i = 0; i < neighbors.size(); i++) {
+                if ( !visited->marked(neighbors.index(i)) ) {
+                    visited->mark(neighbors.index(i));
+                    queue.push_back(neighbors[i]);
+                    reached++;
+                }
+            }
+        }
+    } else {
+        IndexQueue & queue = visited->m_queue;
+        queue.push(voxelIndex(voxel_list, start));
+        while (!queue.empty()) {
+            Voxel current = voxelAt(voxel_list, queue.front());
+            queue.pop();
+            forEachNeighbor(voxel_list, current, 1, [&](const Voxel & next, unsigned int index) {
+                if (visited->testAndMark(index)) {
+                    queue.push(index);
+                    reached++;
+                }
+            });
+        }
+    }
+    return reached;
+}
+
+/**
+    Labels every component of a label with one breadth first search per component, the way the
+    connectivity checks did before component labeling.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param label The label to group.
+    @return The number of components.
+*/
+static unsigned int bfsLabel(CompFab::VoxelGrid * voxel_list, unsigned int label) {
+    ScratchLease visited(voxel_list->m_size);
+    IndexQueue & queue = visited->m_queue;
+    unsigned int components = 0;
+    for (unsigned int i = 0; i < voxel_list->m_size; i++) {
+        if (voxel_list->m_insideArray[i] != label || !visited->testAndMark(i)) {
+            continue;
+        }
+        components++;
+        queue.push(i);
+        while (!queue.empty()) {
+            Voxel current = voxelAt(voxel_list, queue.front());
+            queue.pop();
+            forEachNeighbor(voxel_list, current, label, [&](const Voxel & next, unsigned int index) {
+                if (visited->testAndMark(index)) {
+                    queue.push(index);
+                }
+            });
+        }
+    }
+    return components;
+}
+
+/**
+    Runs a workload until at least a quarter second has passed and prints its throughput.
+
+    @param name The workload's name.
+    @param nodes The number of voxels one run visits.
+    @param run The workload.
+    @param bytes The number of bytes one run streams through memory, or 0 to leave out GB/s.
+*/
+template <typename Workload>
+static void measure(const std::string & name, unsigned long long nodes, Workload run, unsigned long long bytes = 0) {
+    typedef std::chrono::steady_clock Clock;
+    run();
+    unsigned long long reps = 0;
+    Clock::time_point start = Clock::now();
+    double seconds = 0;
+    while (seconds < 0.25) {
+        run();
+        reps++;
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    std::cout << std::left << std::setw(24) << name << std::right << std::setw(10) << std::fixed << std::setprecision(3)
+              << seconds*1e3/reps << " ms/run " << std::setw(10) << std::setprecision(1) << nodes*reps/seconds/1e6 << " Mnodes/s";
+    if (bytes != 0) {
+        std::cout << std::setw(10) << std::setprecision(2) << bytes*reps/seconds/1e9 << " GB/s";
+    }
+    std::cout << std::endl;
+}
+
+/**
+    Prints how a check went.
+
+    @param name The check's name.
+    @param cases The number of cases tried.
+    @param mismatches The number of cases that disagreed with the reference.
+    @return mismatches, so results can be added up.
+*/
+static unsigned int report(const std::string & name, unsigned int cases, unsigned int mismatches) {
+    std::cout << std::left << std::setw(24) << name << std::right << std::setw(10) << cases << " cases "
+              << std::setw(10) << mismatches << " mismatches" << std::endl;
+    return mismatches;
+}
+
+/**
+    Checks floodFill against a breadth first search over random volumes, some wider than one word
+    along x, each seeded with a few voxels that may lie outside the allowed set.
+
+    @param cases The number of volumes to try.
+    @return The number of volumes whose fill differed from the search.
+*/
+static unsigned int checkFloodFill(unsigned int cases) {
+    unsigned int mismatches = 0;
+    for (unsigned int c = 0; c < cases; c++) {
+        unsigned int dimX = 1 + std::rand() % 150;
+        unsigned int dimY = 1 + std::rand() % 12;
+        unsigned int dimZ = 1 + std::rand() % 12;
+        int density = 40 + std::rand() % 50;
+        BitVolume allowed(dimX, dimY, dimZ);
+        std::vector<char> open(dimX*dimY*dimZ);
+        for (unsigned int i = 0; i < open.size(); i++) {
+            open[i] = std::rand() % 100 < density;
+            if (open[i]) {
+                allowed.set(Voxel(i % dimX, i / dimX % dimY, i / (dimX*dimY)));
+            }
+        }
+        BitVolume reach(dimX, dimY, dimZ);
+        std::vector<char> reached(open.size());
+        std::vector<unsigned int> queue;
+        for (int s = std::rand() % 4; s > 0; s--) {
+            unsigned int i = std::rand() % open.size();
+            reach.set(Voxel(i % dimX, i / dimX % dimY, i / (dimX*dimY)));
+            if (open[i] && !reached[i]) {
+                reached[i] = true;
+                queue.push_back(i);
+            }
+        }
+        floodFill(allowed, &reach);
+        int step[6] = {-1, 1, -(int)dimX, (int)dimX, -(int)(dimX*dimY), (int)(dimX*dimY)};
+        for (unsigned int head = 0; head < queue.size(); head++) {
+            unsigned int i = queue[head];
+            unsigned int coord[3] = {i % dimX, i / dimX % dimY, i / (dimX*dimY)};
+            unsigned int dims[3] = {dimX, dimY, dimZ};
+            for (int d = 0; d < 6; d++) {
+                if ((d % 2 == 0 && coord[d/2] == 0) || (d % 2 == 1 && coord[d/2] + 1 == dims[d/2])) {
+                    continue;
+                }
+                unsigned int next = i + step[d];
+                if (open[next] && !reached[next]) {
+                    reached[next] = true;
+                    queue.push_back(next);
+                }
+            }
+        }
+        for (unsigned int i = 0; i < open.size(); i++) {
+            if (reach.test(Voxel(i % dimX, i / dimX % dimY, i / (dimX*dimY))) != (bool)reached[i]) {
+                mismatches++;
+                break;
+            }
+        }
+    }
+    return report("floodFill", cases, mismatches);
+}
+
+/**
+    Checks whether the unassigned voxels outside a piece are connected with loadLabel and one flood
+    fill, as a reference for the remainder oracle.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param piece The voxels to leave out.
+    @return true if what is left is connected or empty, false otherwise.
+*/
+static bool fillConnected(CompFab::VoxelGrid * voxel_list, const Piece & piece) {
+    BitVolume remainder(voxel_list->m_dimX, voxel_list->m_dimY, voxel_list->m_dimZ);
+    loadLabel(voxel_list, 1, &remainder);
+    for (int i = 0; i < piece.size(); i++) {
+        remainder.reset(piece[i]);
+    }
+    if (!remainder.any()) {
+        return true;
+    }
+    BitVolume reach(voxel_list->m_dimX, voxel_list->m_dimY, voxel_list->m_dimZ);
+    reach.set(remainder.first());
+    floodFill(remainder, &reach);
+    return reach.covers(remainder);
+}
+
+/**
+    Checks the remainder oracle against fillConnected. Each grid starts as one random region of
+    unassigned voxels that pieces are grown in, queried, and sometimes assigned or handed back, so
+    the oracle sees both incremental updates and full recomputes.
+
+    @param cases The number of grids to try.
+    @return The number of queries answered differently from the flood fill.
+*/
+static unsigned int checkRemainderOracle(unsigned int cases) {
+    unsigned int mismatches = 0;
+    unsigned int queries = 0;
+    unsigned long long local = 0;
+    unsigned long long full = 0;
+    for (unsigned int c = 0; c < cases; c++) {
+        int dim = 4 + std::rand() % 21;
+        int density = 55 + std::rand() % 45;
+        CompFab::VoxelGrid *grid = new CompFab::VoxelGrid(CompFab::Vec3(0, 0, 0), dim, dim, dim, 1.0);
+        for (unsigned int i = 0; i < grid->m_size; i++) {
+            grid->m_insideArray[i] = std::rand() % 100 < density;
+        }
+        // Keep one region, as a voxelized model would be, so most queries start out connected
+        BitVolume unassigned(dim, dim, dim);
+        BitVolume region(dim, dim, dim);
+        loadLabel(grid, 1, &unassigned);
+        if (unassigned.any()) {
+            region.set(unassigned.first());
+            floodFill(unassigned, &region);
+        }
+        for (unsigned int i = 0; i < grid->m_size; i++) {
+            grid->m_insideArray[i] = region.test(voxelAt(grid, i));
+        }
+        buildRemainderOracle(grid);
+        std::vector<Voxel> assigned;
+        for (int step = 0; step < 30; step++) {
+            // A piece grown breadth first from a random unassigned voxel, plus a stray voxel
+            Piece piece;
+            unsigned int start = std::rand() % grid->m_size;
+            if (grid->m_insideArray[start] == 1) {
+                unsigned int size = 1 + std::rand() % (2*dim*dim);
+                piece.insert(voxelAt(grid, start));
+                for (int head = 0; head < piece.size() && piece.size() < size; head++) {
+                    Voxel current = piece[head];
+                    forEachNeighbor(grid, current, 1, [&](const Voxel & next, unsigned int index) {
+                        if (piece.size() < size) {
+                            piece.insert(next);
+                        }
+                    });
+                }
+            }
+            piece.insert(voxelAt(grid, std::rand() % grid->m_size));
+            queries++;
+            if (g_remainderOracle->staysConnected(piece) != fillConnected(grid, piece) ||
+                g_remainderOracle->connected() != fillConnected(grid, Piece())) {
+                mismatches++;
+            }
+            int action = std::rand() % 10;
+            if (action < 3) {
+                for (int i = 0; i < piece.size(); i++) {
+                    if (grid->isInside(piece[i].x, piece[i].y, piece[i].z) == 1) {
+                        setVoxelLabel(grid, piece[i], 2);
+                        assigned.push_back(piece[i]);
+                    }
+                }
+            } else if (action == 3 && !assigned.empty()) {
+                unsigned int keep = std::rand() % assigned.size();
+                for (unsigned int i = keep; i < assigned.size(); i++) {
+                    setVoxelLabel(grid, assigned[i], 1);
+                }
+                assigned.resize(keep);
+            }
+        }
+        local += g_remainderOracle->m_localChecks;
+        full += g_remainderOracle->m_fullChecks;
+        delete g_remainderOracle;
+        g_remainderOracle = NULL;
+        delete grid;
+    }
+    report("remainder oracle", queries, mismatches);
+    std::cout << "  " << local << " answered locally, " << full << " by flood fill" << std::endl;
+    return mismatches;
+}
+
+/**
+    Counts the face-connected components of a set of voxels with one breadth first search per
+    component, as a reference for the block forest.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param cells The voxels. Only face neighbors that are both in the set are adjacent.
+    @param label The label every voxel of the set holds.
+    @return The number of components.
+*/
+static unsigned int bfsComponents(CompFab::VoxelGrid * voxel_list, const Piece & cells, unsigned int label) {
+    ScratchLease visited(voxel_list->m_size);
+    IndexQueue & queue = visited->m_queue;
+    unsigned int components = 0;
+    for (int i = 0; i < cells.size(); i++) {
+        if (!visited->testAndMark(voxelIndex(voxel_list, cells[i]))) {
+            continue;
+        }
+        components++;
+        queue.push(voxelIndex(voxel_list, cells[i]));
+        while (!queue.empty()) {
+            Voxel current = voxelAt(voxel_list, queue.front());
+            queue.pop();
+            forEachNeighbor(voxel_list, current, label, [&](const Voxel & next, unsigned int index) {
+                if (cells.contains(next) && visited->testAndMark(index)) {
+                    queue.push(index);
+                }
+            });
+        }
+    }
+    return components;
+}
+
+/**
+    Checks the block forest against bfsComponents. Each case labels a random scatter of voxels and
+    builds a forest over most of them, so some neighbors holding the label stay out of it. Voxels
+    are then removed in random order until none are left; before each removal, splits and
+    keepsConnected are compared with searches of the set with and without the voxel, and after it
+    the forest's component count is.
+
+    @param cases The number of sets to try.
+    @return The number of removals where the forest disagreed with the searches.
+*/
+static unsigned int checkBlockForest(unsigned int cases) {
+    const unsigned int label = 3;
+    unsigned int mismatches = 0;
+    unsigned int removals = 0;
+    for (unsigned int c = 0; c < cases; c++) {
+        int dim = 3 + std::rand() % 8;
+        int density = 45 + std::rand() % 55;
+        CompFab::VoxelGrid *grid = new CompFab::VoxelGrid(CompFab::Vec3(0, 0, 0), dim, dim, dim, 1.0);
+        Piece cells;
+        for (unsigned int i = 0; i < grid->m_size; i++) {
+            if (std::rand() % 100 < density) {
+                grid->m_insideArray[i] = label;
+                if (std::rand() % 10 != 0) {
+                    cells.insert(voxelAt(grid, i));
+                }
+            }
+        }
+        BlockForest forest(grid, cells, label);
+        unsigned int components = bfsComponents(grid, cells, label);
+        if (forest.m_components != components) {
+            mismatches++;
+        }
+        while (cells.size() > 0) {
+            Voxel voxel = cells[std::rand() % cells.size()];
+            unsigned int v = forest.id(voxel);
+            cells.erase(voxel);
+            unsigned int without = bfsComponents(grid, cells, label);
+            // The other components are untouched, so the rest is what the voxel's own one became
+            unsigned int pieces = without + 1 - components;
+            bool wrong = false;
+            if (std::rand() % 2 == 0) {
+                wrong = forest.keepsConnected(v) != (without == 1);
+                wrong = wrong || forest.splits(v) != pieces;
+            } else {
+                wrong = forest.splits(v) != pieces;
+                wrong = wrong || forest.keepsConnected(v) != (without == 1);
+            }
+            forest.remove(v);
+            components = without;
+            wrong = wrong || forest.m_components != components;
+            removals++;
+            if (wrong) {
+                mismatches++;
+            }
+        }
+        delete grid;
+    }
+    return report("block forest", removals, mismatches);
+}
+
+/**
+    Cross-checks the connectivity shortcuts against plain searches on random inputs.
+
+    @param seed The seed for std::rand.
+    @return The number of mismatches found.
+*/
+static unsigned int runChecks(unsigned int seed) {
+    std::srand(seed);
+    unsigned int mismatches = 0;
+    mismatches += checkFloodFill(3000);
+    mismatches += checkRemainderOracle(800);
+    mismatches += checkBlockForest(200);
+    return mismatches;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && std::string(argv[1]) == "check") {
+        return runChecks(argc > 2 ? std::atoi(argv[2]) : 1) == 0 ? 0 : 1;
+    }
+    int dim = argc > 1 ? std::atoi(argv[1]) : 64;
+    CompFab::VoxelGrid *grid = makeSphere(dim);
+    AccessibilityGrid scores(CompFab::Vec3(0, 0, 0), dim, dim, dim);
+    buildRayIndex(grid);
+
+    // A thin cap off the top of the sphere stands in for a piece
+    Piece piece;
+    for (unsigned int i = 0; i < grid->m_size; i++) {
+        Voxel voxel = voxelAt(grid, i);
+        if (grid->m_insideArray[i] == 1 && voxel.z >= dim - dim/8) {
+            piece.insert(voxel);
+        }
+    }
+    // A small ball against the surface stands in for a key
+    Piece key;
+    Voxel center(dim/2, dim/2, 2);
+    for (unsigned int i = 0; i < grid->m_size; i++) {
+        Voxel voxel = voxelAt(grid, i);
+        Voxel d = voxel - center;
+        if (grid->m_insideArray[i] == 1 && d.x*d.x + d.y*d.y + d.z*d.z <= dim*dim/64) {
+            key.insert(voxel);
+        }
+    }
+    Voxel seed = voxelAt(grid, std::find(grid->m_insideArray, grid->m_insideArray + grid->m_size, 1u) - grid->m_insideArray);
+    unsigned long long whole = remainderBfs(grid, Piece(), false);
+    unsigned long long remainder = remainderBfs(grid, piece, false);
+    std::cout << "sphere dim " << dim << ", " << whole << " voxels reachable, " << remainder << " outside the piece" << std::endl;
+
+    measure("bfs (std::list)", whole, [&]() { listBfs(grid, &scores, seed, Voxel(0, 0, 1), INT_MAX, 10); });
+    measure("bfs (ring buffer)", whole, [&]() { bfs(grid, &scores, seed, Voxel(0, 0, 1), INT_MAX, 10); });
+    measure("verify bfs (std::list)", remainder, [&]() { remainderBfs(grid, piece, true); });
+    measure("verify bfs (ring buffer)", remainder, [&]() { remainderBfs(grid, piece, false); });
+    measure("verifyPiece", remainder, [&]() { verifyPiece(grid, piece); });
+    measure("verifyPiece (key)", whole - key.size(), [&]() { verifyPiece(grid, key); });
+
+    ComponentLabels components;
+    measure("label (bfs)", whole, [&]() { bfsLabel(grid, 1); });
+    measure("label (1 thread)", whole, [&]() { labelComponents(grid, 1, &components, 1); });
+    measure("label (4 threads)", whole, [&]() { labelComponents(grid, 1, &components, 4); });
+
+    // Corner to corner through the sphere under each path mode; the puzzle itself runs PATH_BFS
+    unsigned int last = grid->m_size - 1;
+    while (grid->m_insideArray[last] != 1) {
+        last--;
+    }
+    Voxel goal = voxelAt(grid, last);
+    const char *modeNames[PATH_MODE_COUNT] = {"bfs", "bidirectional", "a*"};
+    for (int mode = 0; mode < PATH_MODE_COUNT; mode++) {
+        g_pathMode = (PathMode)mode;
+        unsigned long long expanded = 0;
+        unsigned int length = 0;
+        measure(std::string("path (") + modeNames[mode] + ")", whole, [&]() {
+            VoxelSearch search(grid, 1);
+            length = search.pointPath(seed, goal).size();
+            expanded = search.m_expanded;
+        });
+        std::cout << "  path of " << length << " voxels, " << expanded << " cells expanded" << std::endl;
+    }
+    g_pathMode = PATH_BFS;
+
+    // Assigning the cap and handing it back, with the scores brought up to date after each
+    measure("scores (recursive)", 2*grid->m_size, [&]() { delete legacyScores(grid, 0.1, 3, 1); delete legacyScores(grid, 0.1, 3, 1); });
+    measure("scores (full)", 2*grid->m_size, [&]() { delete accessibilityScores(grid, 0.1, 3, 1); delete accessibilityScores(grid, 0.1, 3, 1); });
+    // One level of the stencil per kernel; each cell reads its mask and score and writes a score
+    AccessibilityScorer scorer;
+    std::vector<double> level(grid->m_size);
+    scorer.score(grid, 0.1, 3, 1, level.data());
+    StencilMode best = g_stencilMode;
+    for (int mode = STENCIL_SCALAR; mode <= best; mode++) {
+        g_stencilMode = (StencilMode)mode;
+        measure(std::string("stencil (") + stencilModeName(g_stencilMode) + ")", grid->m_size, [&]() {
+            stencilLevel(grid, scorer.m_neighbors.data(), scorer.m_buffer.data(), 0.001, level.data(), 1);
+        }, grid->m_size*(sizeof(uint8_t) + 2*sizeof(double)));
+    }
+    g_stencilMode = best;
+    // Whole scores split into z slabs; only scales with cores to spare
+    unsigned int counts[3] = { 1, 4, workerCount() };
+    for (int c = 0; c < 3; c++) {
+        if (c == 2 && (counts[c] == 1 || counts[c] == 4)) {
+            break;
+        }
+        AccessibilityScorer threaded(counts[c]);
+        measure("scores (" + std::to_string(counts[c]) + " slabs)", grid->m_size, [&]() {
+            threaded.score(grid, 0.1, 3, 1, level.data());
+        });
+        // What currentAccessibility's first call scores, every level kept
+        measure("engine (" + std::to_string(counts[c]) + " slabs)", grid->m_size, [&]() {
+            AccessibilityEngine engine(grid, 0.1, 3, 1, counts[c]);
+        });
+    }
+    measure("engine (auto slabs)", grid->m_size, [&]() { AccessibilityEngine engine(grid, 0.1, 3, 1); });
+    currentAccessibility(grid, 0.1, 3, 1);
+    measure("scores (refresh)", 2*grid->m_size, [&]() {
+        for (int i = 0; i < piece.size(); i++) {
+            setVoxelLabel(grid, piece[i], 3);
+        }
+        currentAccessibility(grid, 0.1, 3, 1);
+        for (int i = 0; i < piece.size(); i++) {
+            setVoxelLabel(grid, piece[i], 1);
+        }
+        currentAccessibility(grid, 0.1, 3, 1);
+    });
+
+    // The column sum expandPiece takes for a candidate, from every unassigned voxel straight up
+    AccessibilityGrid *refreshed = currentAccessibility(grid, 0.1, 3, 1);
+    std::vector<Voxel> column;
+    double columns = 0;
+    measure("column sums (ray)", whole, [&]() {
+        for (unsigned int i = 0; i < grid->m_size; i++) {
+            if (grid->m_insideArray[i] == 1) {
+                column.clear();
+                collectAlongRay(grid, voxelAt(grid, i), Voxel(0, 0, 1), 1, &column);
+                for (int j = 0; j < column.size(); j++) {
+                    columns += refreshed->score(column[j].x, column[j].y, column[j].z);
+                }
+            }
+        }
+    });
+    buildScorePrefix(grid, refreshed);
+    measure("column sums (prefix)", whole, [&]() {
+        for (unsigned int i = 0; i < grid->m_size; i++) {
+            if (grid->m_insideArray[i] == 1) {
+                columns += g_scorePrefix->runSum(voxelAt(grid, i), POS_Z);
+            }
+        }
+    });
+    std::cout << "score sums rebuilt " << g_scorePrefix->m_rebuilt << " lines" << std::endl;
+
+    // Grow the key's center by columns along +z to 1/512 of the sphere, with the same draws both ways
+    Piece start;
+    start.insert(center);
+    Piece grownLegacy;
+    Piece grown;
+    measure("expand (rescan)", whole/512, [&]() {
+        std::srand(1);
+        grownLegacy = legacyExpand(grid, refreshed, start, std::vector<Voxel>(), whole/512, Voxel(0, 0, 1));
+    });
+    measure("expand (frontier)", whole/512, [&]() {
+        std::srand(1);
+        grown = expandPiece(grid, refreshed, start, std::vector<Voxel>(), whole/512, Voxel(0, 0, 1));
+    });
+    std::cout << "center grown to " << grownLegacy.size() << " (rescan) and " << grown.size() << " (frontier), "
+              << (grownLegacy.voxels() == grown.voxels() ? "same" : "different") << " pieces" << std::endl;
+
+    // Answered locally from here on, so nodes/s counts the remainder the oracle didn't visit
+    buildRemainderOracle(grid);
+    measure("oracle", remainder, [&]() { verifyPiece(grid, piece); });
+    measure("oracle (key)", whole - key.size(), [&]() { verifyPiece(grid, key); });
+    std::cout << "oracle answered " << g_remainderOracle->m_localChecks << " queries locally, "
+              << g_remainderOracle->m_fullChecks << " by flood fill" << std::endl;
+
+    // Split the key, labelled as a piece, in half; partitionPiece logs every step, so mute it
+    for (int i = 0; i < key.size(); i++) {
+        setVoxelLabel(grid, key[i], 3);
+    }
+    std::streambuf *out = std::cout.rdbuf();
+    Piece legacy;
+    Piece current;
+    measure("partition (rescan)", key.size(), [&]() {
+        std::cout.rdbuf(NULL);
+        legacy = legacyPartition(grid, &scores, key, 3, key.size()/2);
+        std::cout.rdbuf(out);
+    });
+    measure("partition (blocks)", key.size(), [&]() {
+        std::cout.rdbuf(NULL);
+        current = partitionPiece(grid, &scores, key, 3, key.size()/2);
+        std::cout.rdbuf(out);
+    });
+    std::cout << "key of " << key.size() << " split into " << legacy.size() << " (rescan) and " << current.size() << " (blocks), "
+              << (legacy.voxels() == current.voxels() ? "same" : "different") << " partitions" << std::endl;
+
+    // Cut the sphere into eight pieces, one per octant, and score them all for partitioning
+    for (unsigned int i = 0; i < grid->m_size; i++) {
+        if (grid->m_insideArray[i] != 0) {
+            Voxel voxel = voxelAt(grid, i);
+            setVoxelLabel(grid, voxel, 3 + (voxel.x >= dim/2) + 2*(voxel.y >= dim/2) + 4*(voxel.z >= dim/2));
+        }
+    }
+    measure("8 pieces (per label)", 8*grid->m_size, [&]() {
+        for (int p = 3; p < 11; p++) {
+            delete accessibilityScores(grid, 0.1, 3, p);
+        }
+    });
+    measure("8 pieces (one pass)", 8*grid->m_size, [&]() { scorer.scoreOwnLabels(grid, 0.1, 3, level.data()); });
+
+    // A frontier of weighted candidates that changes one weight per draw, as expandPiece's does
+    std::vector<double> weights(grid->m_size / 8);
+    for (unsigned int i = 0; i < weights.size(); i++) {
+        weights[i] = std::pow(1.0 + (i * 2654435761u) % 97, -2.0);
+    }
+    const unsigned int draws = 1000;
+    long long drawn = 0;
+    measure("draws (scan)", draws, [&]() {
+        std::vector<double> changed = weights;
+        for (unsigned int d = 0; d < draws; d++) {
+            changed[(d * 40503u) % changed.size()] *= 0.5;
+            double dist = 0;
+            for (unsigned int i = 0; i < changed.size(); i++) {
+                dist += changed[i];
+            }
+            double random = (double) std::rand() / (RAND_MAX);
+            double accum = 0.0;
+            for (unsigned int i = 0; i < changed.size(); i++) {
+                if (random < accum + changed[i] / dist) {
+                    drawn += i;
+                    break;
+                }
+                accum += changed[i] / dist;
+            }
+        }
+    });
+    WeightSampler sampler;
+    measure("draws (fenwick)", draws, [&]() {
+        sampler.assign(weights);
+        for (unsigned int d = 0; d < draws; d++) {
+            unsigned int slot = (d * 40503u) % weights.size();
+            sampler.set(slot, sampler.weight(slot) * 0.5);
+            drawn += sampler.draw((double) std::rand() / (RAND_MAX));
+        }
+    });
+
+    delete grid;
+    return 0;
+}
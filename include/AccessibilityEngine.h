@@ -0,0 +1,56 @@
+/**
+    CS591-W1 Final Project
+    AccessibilityEngine.h
+    Purpose: Headers for keeping accessibility scores current as voxels change label.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#ifndef ACCESSIBILITYENGINE_H
+#define ACCESSIBILITYENGINE_H
+
+#include <cstdint>
+#include <vector>
+#include "CompFab.h"
+#include "ExtractPartitions.h"
+
+/*
+    The accessibility scores of one label, with every level of the recursion in
+    accessibilityScores kept between calls. Level 0 counts each cell's neighbors holding the label,
+    and level r adds alpha^r times the level r-1 scores of those neighbors to the cell's own.
+
+    A voxel changing to or from the label only changes level r within r+1 steps of it, so
+    setVoxelLabel records it and refresh recomputes just those balls around the recorded voxels,
+    level by level, with the same arithmetic as a full pass. The scores stay bit-identical to
+    accessibilityScores while a refresh costs in proportion to the voxels that changed.
+*/
+typedef struct AccessibilityEngineStruct {
+    AccessibilityEngineStruct(CompFab::VoxelGrid * voxel_list, double alpha, unsigned int recurse, int pieceId, unsigned int threads = 0);
+
+    void touch(const Voxel & voxel);
+    AccessibilityGrid * refresh();
+    inline bool matches(CompFab::VoxelGrid * voxel_list, double alpha, unsigned int recurse, int pieceId) const {
+        return m_grid == voxel_list && m_alpha == alpha && m_recurse == recurse && m_label == pieceId;
+    }
+
+    CompFab::VoxelGrid *m_grid;
+    double m_alpha;
+    unsigned int m_recurse;
+    int m_label;
+    //Scores of each level of the recursion; the last one is m_scores
+    std::vector<std::vector<double> > m_levels;
+    AccessibilityGrid m_scores;
+    //Voxels whose label changed since the last refresh, each once
+    std::vector<uint32_t> m_changed;
+    std::vector<bool> m_pending;
+    //Cells recomputed by refreshes so far, summed over levels
+    unsigned long long m_recomputed;
+
+} AccessibilityEngine;
+
+//The engine currentAccessibility refreshes, kept current by setVoxelLabel
+extern AccessibilityEngine * g_accessibility;
+
+AccessibilityGrid * currentAccessibility( CompFab::VoxelGrid * voxel_list, double alpha, unsigned int recurse, int pieceId);
+
+#endif
@@ -0,0 +1,45 @@
+/**
+    CS591-W1 Final Project
+    AccessibilityScorer.h
+    Purpose: Headers for scoring accessibility level by level in reused buffers.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#ifndef ACCESSIBILITYSCORER_H
+#define ACCESSIBILITYSCORER_H
+
+#include <cstdint>
+#include <vector>
+#include "CompFab.h"
+#include "ExtractPartitions.h"
+
+/*
+    Scores the recursion of accessibilityScores from level 0 up instead of from the top down. Each
+    cell's neighbors holding the label are found once per call and kept as a six bit mask in
+    forEachNeighbor order, which is also level 0, and every later level is one stencilLevel pass
+    that reads the level below from one buffer and writes into the other. The buffers are kept
+    between calls, so scoring allocates nothing once they have grown to the grid, and the sums are
+    taken in the same order as before, so the scores are bit-identical.
+
+    scoreOwnLabels instead scores each cell for whatever label it holds, which covers every label
+    in the same single pass.
+*/
+typedef struct AccessibilityScorerStruct {
+    AccessibilityScorerStruct(unsigned int threads = 0);
+
+    void score(CompFab::VoxelGrid * voxel_list, double alpha, unsigned int recurse, int pieceId, double * scores);
+    void scoreOwnLabels(CompFab::VoxelGrid * voxel_list, double alpha, unsigned int recurse, double * scores);
+    void scoreMatching(CompFab::VoxelGrid * voxel_list, double alpha, unsigned int recurse, int pieceId, bool ownLabel, double * scores);
+    unsigned int buildMasks(CompFab::VoxelGrid * voxel_list, int pieceId, bool ownLabel, double * level);
+
+    //Neighbors of each cell holding the scored label, bit d set for the neighbor in Direction d
+    std::vector<uint8_t> m_neighbors;
+    //The level the result isn't written to, every other level
+    std::vector<double> m_buffer;
+    //Threads to score with, or 0 to pick from the grid size
+    unsigned int m_threads;
+
+} AccessibilityScorer;
+
+#endif
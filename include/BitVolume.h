@@ -0,0 +1,54 @@
+/**
+    CS591-W1 Final Project
+    BitVolume.h
+    Purpose: Headers for bit-packed voxel sets and word-parallel flood fill over them.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#ifndef BITVOLUME_H
+#define BITVOLUME_H
+
+#include <cstdint>
+#include <vector>
+#include "CompFab.h"
+#include "ExtractPartitions.h"
+
+/*
+    One bit per voxel. Each row of constant (y, z) is m_words 64-bit words along x, and row
+    z*dimY + y starts at word (z*dimY + y)*m_words, the same layout as the x lines of RayIndex.
+    Bits past dimX in a row's last word are always zero.
+*/
+typedef struct BitVolumeStruct {
+    BitVolumeStruct(unsigned int dimX, unsigned int dimY, unsigned int dimZ);
+
+    inline unsigned int row(int y, int z) const { return z*m_dimY + y; }
+    inline uint64_t * rowWords(unsigned int r) { return &m_bits[(size_t)r*m_words]; }
+    inline const uint64_t * rowWords(unsigned int r) const { return &m_bits[(size_t)r*m_words]; }
+
+    inline bool test(const Voxel & voxel) const {
+        return (rowWords(row(voxel.y, voxel.z))[voxel.x >> 6] >> (voxel.x & 63)) & 1;
+    }
+    inline void set(const Voxel & voxel) {
+        rowWords(row(voxel.y, voxel.z))[voxel.x >> 6] |= (uint64_t)1 << (voxel.x & 63);
+    }
+    inline void reset(const Voxel & voxel) {
+        rowWords(row(voxel.y, voxel.z))[voxel.x >> 6] &= ~((uint64_t)1 << (voxel.x & 63));
+    }
+
+    void clear();
+    bool any() const;
+    Voxel first() const;
+    bool covers(const BitVolumeStruct & other) const;
+
+    unsigned int m_dimX, m_dimY, m_dimZ;
+    unsigned int m_words;
+    unsigned int m_rows;
+    std::vector<uint64_t> m_bits;
+
+} BitVolume;
+
+void loadLabel( CompFab::VoxelGrid * voxel_list, unsigned int label, BitVolume * volume);
+unsigned int floodFill(const BitVolume & allowed, BitVolume * reach);
+
+#endif
@@ -0,0 +1,62 @@
+/**
+    CS591-W1 Final Project
+    BlockForest.h
+    Purpose: Headers for tracking the biconnected blocks and articulation points of a set of voxels.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#ifndef BLOCKFOREST_H
+#define BLOCKFOREST_H
+
+#include <vector>
+#include "CompFab.h"
+#include "ExtractPartitions.h"
+
+//Id of a voxel not in the forest, or of a missing neighbor
+#define BLOCK_FOREST_NONE 0xFFFFFFFFu
+
+/*
+    The blocks (biconnected components, bridges included) of the face-adjacency graph of a set of
+    voxels, found with Tarjan's algorithm. A voxel in k blocks is an articulation point when k > 1;
+    taking it out splits its component into k, or removes the component if it is alone (k = 0).
+    So whether a removal keeps the set connected is known before making it.
+
+    Removing a voxel only changes the blocks it was in. Those are marked dirty and searched again
+    the next time they are needed. Most questions don't need them: a short search from the voxel's
+    neighbors, merging where they meet, usually settles whether they stay connected without it.
+*/
+typedef struct BlockForestStruct {
+    BlockForestStruct(CompFab::VoxelGrid * voxel_list, const Piece & voxels, unsigned int label);
+
+    unsigned int id(const Voxel & voxel) const;
+    unsigned int splits(unsigned int v);
+    bool keepsConnected(unsigned int v);
+    void remove(unsigned int v);
+
+    //The voxels of the forest, in the order given; a voxel's id is its position
+    Piece m_cells;
+    //Ids of the face neighbors of each voxel, six per voxel in forEachNeighbor order
+    std::vector<unsigned int> m_adjacent;
+    std::vector<char> m_alive;
+    unsigned int m_size;
+    unsigned int m_components;
+    std::vector<std::vector<unsigned int> > m_blocks;
+    std::vector<std::vector<unsigned int> > m_blocksOf;
+    //Blocks that lost a voxel since they were found
+    std::vector<unsigned int> m_dirty;
+    std::vector<char> m_isDirty;
+    //Discovery times and low points of the last block search, and which voxels it could enter
+    std::vector<unsigned int> m_discovered;
+    std::vector<unsigned int> m_low;
+    std::vector<unsigned int> m_scope;
+    unsigned int m_scopeStamp;
+    //Regions of the last neighborhood search
+    std::vector<unsigned int> m_region;
+    //The last voxel asked about, and how many pieces its component splits into, 2 meaning 2 or more
+    unsigned int m_asked;
+    unsigned int m_askedSplits;
+
+} BlockForest;
+
+#endif
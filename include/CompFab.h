@@ -117,6 +117,8 @@ namespace CompFab
     {
         //Square voxels only
         VoxelGridStruct(Vec3 lowerLeft, unsigned int dimX, unsigned int dimY, unsigned int dimZ, double spacing);
+        //Wraps an existing label array (e.g. a mapped snapshot) without taking ownership
+        VoxelGridStruct(Vec3 lowerLeft, unsigned int dimX, unsigned int dimY, unsigned int dimZ, double spacing, unsigned int *insideArray);
         ~VoxelGridStruct();
 
         inline unsigned int & isInside(unsigned int i, unsigned int j, unsigned int k)
@@ -129,6 +131,7 @@ namespace CompFab
         unsigned int m_dimX, m_dimY, m_dimZ, m_size;
         double m_spacing;
         Vec3 m_lowerLeft;
+        bool m_ownsArray;
         
     } VoxelGrid;
 }
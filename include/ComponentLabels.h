@@ -0,0 +1,73 @@
+/**
+    CS591-W1 Final Project
+    ComponentLabels.h
+    Purpose: Headers for labeling every connected region of the voxel grid at once.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#ifndef COMPONENTLABELS_H
+#define COMPONENTLABELS_H
+
+#include <cstdint>
+#include <vector>
+#include "CompFab.h"
+#include "ExtractPartitions.h"
+#include "Parallel.h"
+
+//Component of a cell outside every region
+#define COMPONENT_NONE 0xFFFFFFFFu
+
+/*
+    Connected components, through face neighbors, of the cells of a grid that pass some test.
+    Components are numbered from 0 in the order of their first cell by linear index, so the
+    numbering does not depend on how many threads did the labeling.
+
+    Labeling is two-pass union-find over z slabs. Each slab links every inside cell to its inside
+    -x, -y and -z neighbors within the slab, always hanging the larger root under the smaller one,
+    all slabs in parallel. The planes where slabs meet are then merged on the calling thread, and
+    finally every cell is resolved to its root's number in parallel, counting component sizes.
+*/
+typedef struct ComponentLabelsStruct {
+    inline unsigned int count() const { return m_sizes.size(); }
+    inline uint32_t component(unsigned int index) const { return m_component[index]; }
+    inline uint32_t component(CompFab::VoxelGrid * voxel_list, const Voxel & voxel) const {
+        return m_component[voxelIndex(voxel_list, voxel)];
+    }
+
+    //Component of each cell, or COMPONENT_NONE
+    std::vector<uint32_t> m_component;
+    //Cells in each component
+    std::vector<unsigned int> m_sizes;
+    //Union-find parent of each cell while labeling, COMPONENT_NONE outside; kept to reuse its memory
+    std::vector<uint32_t> m_parent;
+
+} ComponentLabels;
+
+void labelSeeded(CompFab::VoxelGrid * voxel_list, unsigned int slabs, ComponentLabels * labels);
+void labelComponents(CompFab::VoxelGrid * voxel_list, unsigned int label, ComponentLabels * labels, unsigned int threads = 0);
+
+/**
+    Labels the connected components of the cells that pass a test.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param inside The test, called as inside(index) on every cell's linear index, from several
+                  threads at once.
+    @param labels The labels, replaced.
+    @param threads The number of threads to use, or 0 to pick from the grid size.
+*/
+template <typename Inside>
+void labelComponentsIf(CompFab::VoxelGrid * voxel_list, Inside inside, ComponentLabels * labels, unsigned int threads = 0) {
+    const unsigned int plane = voxel_list->m_dimX*voxel_list->m_dimY;
+    const unsigned int slabs = slabCount(voxel_list->m_size, voxel_list->m_dimZ, threads);
+    labels->m_parent.resize(voxel_list->m_size);
+    uint32_t *parent = labels->m_parent.data();
+    parallelRanges(voxel_list->m_dimZ, slabs, [=](unsigned int slab, unsigned int zBegin, unsigned int zEnd) {
+        for (unsigned int i = zBegin*plane; i < zEnd*plane; i++) {
+            parent[i] = inside(i) ? i : COMPONENT_NONE;
+        }
+    });
+    labelSeeded(voxel_list, slabs, labels);
+}
+
+#endif
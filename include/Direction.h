@@ -0,0 +1,92 @@
+/**
+    CS591-W1 Final Project
+    Direction.h
+    Purpose: The six axis directions, with compile-time offsets and strides for direction-specialized kernels.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#ifndef DIRECTION_H
+#define DIRECTION_H
+
+#include "CompFab.h"
+#include "ExtractPartitions.h"
+
+// Same order as the face neighbors visited by forEachNeighbor
+enum Direction { NEG_X = 0, POS_X = 1, NEG_Y = 2, POS_Y = 3, NEG_Z = 4, POS_Z = 5, NO_DIRECTION = 6 };
+
+constexpr int directionAxis(Direction d) { return (int)d / 2; }
+constexpr int directionSign(Direction d) { return ((int)d & 1) ? 1 : -1; }
+constexpr int directionDX(Direction d) { return directionAxis(d) == 0 ? directionSign(d) : 0; }
+constexpr int directionDY(Direction d) { return directionAxis(d) == 1 ? directionSign(d) : 0; }
+constexpr int directionDZ(Direction d) { return directionAxis(d) == 2 ? directionSign(d) : 0; }
+constexpr Direction oppositeDirection(Direction d) { return (Direction)((int)d ^ 1); }
+
+/**
+    The step of a direction as a voxel offset.
+*/
+inline Voxel directionVoxel(Direction d) {
+    return Voxel(directionDX(d), directionDY(d), directionDZ(d));
+}
+
+/**
+    The direction of a unit axis step, or NO_DIRECTION for anything else.
+*/
+inline Direction toDirection(const Voxel & dir) {
+    if (dir.y == 0 && dir.z == 0 && (dir.x == 1 || dir.x == -1)) {
+        return dir.x > 0 ? POS_X : NEG_X;
+    }
+    if (dir.x == 0 && dir.z == 0 && (dir.y == 1 || dir.y == -1)) {
+        return dir.y > 0 ? POS_Y : NEG_Y;
+    }
+    if (dir.x == 0 && dir.y == 0 && (dir.z == 1 || dir.z == -1)) {
+        return dir.z > 0 ? POS_Z : NEG_Z;
+    }
+    return NO_DIRECTION;
+}
+
+/**
+    The linear index offset of one step in direction D, matching VoxelGrid::isInside.
+*/
+template <Direction D>
+inline int directionStride(CompFab::VoxelGrid * voxel_list) {
+    return directionAxis(D) == 0 ? directionSign(D)
+         : directionAxis(D) == 1 ? directionSign(D)*(int)voxel_list->m_dimY
+         : directionSign(D)*(int)(voxel_list->m_dimX*voxel_list->m_dimY);
+}
+
+/**
+    The number of steps in direction D from a voxel before the next one would leave the grid.
+*/
+template <Direction D>
+inline int stepsToEdge(CompFab::VoxelGrid * voxel_list, const Voxel & from) {
+    return directionAxis(D) == 0 ? (directionSign(D) > 0 ? (int)voxel_list->m_dimX - 1 - from.x : from.x)
+         : directionAxis(D) == 1 ? (directionSign(D) > 0 ? (int)voxel_list->m_dimY - 1 - from.y : from.y)
+         : (directionSign(D) > 0 ? (int)voxel_list->m_dimZ - 1 - from.z : from.z);
+}
+
+/**
+    The voxel t steps from another in direction D.
+*/
+template <Direction D>
+inline Voxel stepVoxel(const Voxel & from, int t) {
+    return Voxel(from.x + directionDX(D)*t, from.y + directionDY(D)*t, from.z + directionDZ(D)*t);
+}
+
+/**
+    Runs Kernel<d>::run(args...) with d fixed at compile time, so the kernel body sees constant
+    offsets and strides. d must not be NO_DIRECTION.
+*/
+template <template <Direction> class Kernel, typename... Args>
+inline auto dispatchDirection(Direction d, Args... args) -> decltype(Kernel<NEG_X>::run(args...)) {
+    switch (d) {
+        case NEG_X: return Kernel<NEG_X>::run(args...);
+        case POS_X: return Kernel<POS_X>::run(args...);
+        case NEG_Y: return Kernel<NEG_Y>::run(args...);
+        case POS_Y: return Kernel<POS_Y>::run(args...);
+        case NEG_Z: return Kernel<NEG_Z>::run(args...);
+        default: return Kernel<POS_Z>::run(args...);
+    }
+}
+
+#endif
@@ -0,0 +1,94 @@
+/**
+    CS591-W1 Final Project
+    ExpansionFrontier.h
+    Purpose: Headers for the candidate columns expandPiece grows a piece by, kept between steps.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#ifndef EXPANSIONFRONTIER_H
+#define EXPANSIONFRONTIER_H
+
+#include <vector>
+#include <queue>
+#include <utility>
+#include "CompFab.h"
+#include "ExtractPartitions.h"
+#include "ScratchGrid.h"
+#include "GridTransaction.h"
+#include "WeightSampler.h"
+#include "ScorePrefix.h"
+
+/*
+    The unassigned neighbors of a growing piece, each weighted by the score sum of the column it
+    would add along the normal. Cells are taken (added to the piece, or kept out of it as anchors)
+    one at a time, and new neighbors are found only around the cells just added.
+
+    A candidate's column skips taken cells and candidates found after it, as when every candidate
+    was rescored in discovery order each step. So its weight only changes when a cell of its column
+    is taken or becomes a candidate, and rescore() revisits just the candidates behind such cells.
+
+    Slots are numbered in discovery order and never reused, so draws pick the same candidate a scan
+    of the current candidates in that order would. A candidate fits while adding its column keeps
+    the piece within the limit; a max-heap of column sizes finds the ones that stop fitting as the
+    piece grows.
+*/
+typedef struct ExpansionFrontierStruct {
+    ExpansionFrontierStruct(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, Voxel normal, int limit, double exponent);
+
+    inline bool taken(const Voxel & voxel) const { return m_taken->marked(voxelIndex(m_grid, voxel)); }
+    void take(const Voxel & voxel);
+    void grow(const Piece & piece, int from);
+    void rescore(int count);
+    int choose(double random) const;
+
+    CompFab::VoxelGrid *m_grid;
+    AccessibilityGrid *m_scores;
+    //Sums whole columns in one step, when it holds m_scores
+    ScorePrefix *m_prefix;
+    Voxel m_normal;
+    //Axis of the normal, or -1 if it isn't along one, in which case every candidate shares a line
+    int m_axis;
+    int m_sign;
+    int m_limit;
+    double m_exponent;
+
+    //Cells in the piece or kept out of it
+    ScratchLease m_taken;
+    //Candidates, with their slot as value
+    ScratchLease m_slots;
+    std::vector<Voxel> m_voxels;
+    //Cells each candidate's column adds before connectivity is restored
+    std::vector<int> m_columns;
+    std::vector<bool> m_fits;
+    WeightSampler m_all;
+    //Weights of the candidates that fit, 0 for the rest
+    WeightSampler m_fitting;
+    unsigned int m_live;
+    unsigned int m_fitCount;
+    //Column size and slot of candidates that fit; entries go stale when they are rescored
+    std::priority_queue<std::pair<int, unsigned int> > m_heap;
+
+    //Slots of the candidates on each line along the normal, dead ones included
+    std::vector<std::vector<unsigned int> > m_lines;
+    //Cells taken or found since the last rescore
+    std::vector<Voxel> m_changed;
+    //Rescore pass that last touched each line, and how far along the normal its changes went
+    std::vector<unsigned int> m_lineRound;
+    std::vector<int> m_lineReach;
+    std::vector<unsigned int> m_touched;
+    unsigned int m_round;
+    //Candidate scorings so far
+    unsigned long long m_rescored;
+
+    GridTransaction m_trial;
+    std::vector<Voxel> m_column;
+    Piece m_piece;
+
+    unsigned int line(const Voxel & voxel) const;
+    int along(const Voxel & voxel) const;
+    void score(unsigned int slot, int count);
+
+} ExpansionFrontier;
+
+#endif
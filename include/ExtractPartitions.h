@@ -6,10 +6,15 @@
     @author Ben Gaudiosi
     @version 1.0 5/01/2018 
 */
+#ifndef EXTRACTPARTITIONS_H
+#define EXTRACTPARTITIONS_H
+
 #include "CompFab.h"
+#include <cstdint>
 #include <vector>
 #include <tuple>
 #include <string>
+#include <unordered_map>
 
 
 class Voxel {
@@ -20,7 +25,7 @@ class Voxel {
         int y;
         int z;
         int value = 0;
-        std::string toString();
+        std::string toString() const;
         inline void operator+=(const Voxel& a) {
             x += a.x;
             y += a.y;
@@ -33,6 +38,108 @@ inline Voxel operator+(const Voxel& a, const Voxel& b) { return Voxel(a.x + b.x,
 inline Voxel operator-(const Voxel& a, const Voxel& b) { return Voxel(a.x - b.x, a.y - b.y, a.z - b.z); }
 inline bool operator!=(const Voxel& a, const Voxel& b) { return !(a == b); }
 
+/**
+    Linear index of a voxel, matching VoxelGrid::isInside.
+*/
+inline unsigned int voxelIndex( CompFab::VoxelGrid * voxel_list, const Voxel & voxel) {
+    return voxel.z*(voxel_list->m_dimX*voxel_list->m_dimY) + voxel.y*voxel_list->m_dimY + voxel.x;
+}
+
+/**
+    The voxel at a linear index, the inverse of voxelIndex. Like voxelIndex, assumes dimX == dimY.
+*/
+inline Voxel voxelAt( CompFab::VoxelGrid * voxel_list, unsigned int index) {
+    unsigned int slab = voxel_list->m_dimX*voxel_list->m_dimY;
+    unsigned int row = index % slab;
+    return Voxel(row % voxel_list->m_dimY, row / voxel_list->m_dimY, index / slab);
+}
+
+/**
+    Calls visit(neighbor, neighborIndex) for each face neighbor of voxel labelled pieceId, in the
+    order -x, +x, -y, +y, -z, +z. Neighbor indices come from fixed strides, so nothing is allocated.
+*/
+template <typename Visitor>
+inline void forEachNeighbor( CompFab::VoxelGrid * voxel_list, const Voxel & voxel, int pieceId, Visitor visit) {
+    const unsigned int *labels = voxel_list->m_insideArray;
+    const unsigned int label = (unsigned int)pieceId;
+    const unsigned int strideY = voxel_list->m_dimY;
+    const unsigned int strideZ = voxel_list->m_dimX*voxel_list->m_dimY;
+    const unsigned int index = voxelIndex(voxel_list, voxel);
+
+    if (voxel.x != 0 && labels[index - 1] == label) {
+        visit(Voxel(voxel.x-1, voxel.y, voxel.z), index - 1);
+    }
+    if (voxel.x != (int)voxel_list->m_dimX-1 && labels[index + 1] == label) {
+        visit(Voxel(voxel.x+1, voxel.y, voxel.z), index + 1);
+    }
+    if (voxel.y != 0 && labels[index - strideY] == label) {
+        visit(Voxel(voxel.x, voxel.y-1, voxel.z), index - strideY);
+    }
+    if (voxel.y != (int)voxel_list->m_dimY-1 && labels[index + strideY] == label) {
+        visit(Voxel(voxel.x, voxel.y+1, voxel.z), index + strideY);
+    }
+    if (voxel.z != 0 && labels[index - strideZ] == label) {
+        visit(Voxel(voxel.x, voxel.y, voxel.z-1), index - strideZ);
+    }
+    if (voxel.z != (int)voxel_list->m_dimZ-1 && labels[index + strideZ] == label) {
+        visit(Voxel(voxel.x, voxel.y, voxel.z+1), index + strideZ);
+    }
+}
+
+/**
+    Fixed-capacity list of up to six face neighbors, returned by value from getNeighbors.
+*/
+typedef struct NeighborStruct {
+    NeighborStruct() : m_count(0) {}
+
+    inline unsigned int size() const { return m_count; }
+    inline Voxel & operator[](unsigned int i) { return m_voxels[i]; }
+    inline unsigned int index(unsigned int i) const { return m_index[i]; }
+    inline void push_back(const Voxel & voxel, unsigned int index) {
+        m_voxels[m_count] = voxel;
+        m_index[m_count] = index;
+        m_count++;
+    }
+
+    Voxel m_voxels[6];
+    unsigned int m_index[6];
+    unsigned int m_count;
+
+} Neighbors;
+
+/*
+    A piece of the puzzle: its voxels in insertion order, plus a hash from each voxel to its position
+    in that list so membership, insertion and removal are O(1). Removal swaps the last voxel into the
+    hole, so it only preserves order when the removed voxel is the last one.
+*/
+typedef struct PieceStruct {
+    PieceStruct() {}
+    PieceStruct(const std::vector<Voxel> & voxels);
+
+    bool contains(const Voxel & voxel) const;
+    bool insert(const Voxel & voxel);
+    bool erase(const Voxel & voxel);
+    void unite(const PieceStruct & other);
+    void subtract(const PieceStruct & other);
+    void clear();
+
+    inline unsigned int size() const { return m_voxels.size(); }
+    inline bool empty() const { return m_voxels.empty(); }
+    inline const Voxel & operator[](unsigned int i) const { return m_voxels[i]; }
+    inline std::vector<Voxel>::const_iterator begin() const { return m_voxels.begin(); }
+    inline std::vector<Voxel>::const_iterator end() const { return m_voxels.end(); }
+    inline const std::vector<Voxel> & voxels() const { return m_voxels; }
+
+    //Packs a voxel into a hash key, 21 bits per coordinate
+    static inline uint64_t key(const Voxel & voxel) {
+        return ((uint64_t)(uint32_t)voxel.z << 42) | ((uint64_t)((uint32_t)voxel.y & 0x1FFFFF) << 21) | ((uint32_t)voxel.x & 0x1FFFFF);
+    }
+
+    std::vector<Voxel> m_voxels;
+    std::unordered_map<uint64_t, unsigned int> m_position;
+
+} Piece;
+
 class VoxelPair {
     public:
         VoxelPair( Voxel blockerVox, double blockerScore, Voxel blockeeVox, double blockeeScore);
@@ -47,6 +154,7 @@ class VoxelPair {
 typedef struct AccessibilityStruct {
     //Square voxels only
     AccessibilityStruct(CompFab::Vec3 lowerLeft, unsigned int dimX, unsigned int dimY, unsigned int dimZ);
+    AccessibilityStruct(CompFab::Vec3 lowerLeft, unsigned int dimX, unsigned int dimY, unsigned int dimZ, double *scoreArray);
     ~AccessibilityStruct();
 
     inline double & score(unsigned int i, unsigned int j, unsigned int k) {
@@ -56,6 +164,7 @@ typedef struct AccessibilityStruct {
     double *m_scoreArray;
     unsigned int m_dimX, m_dimY, m_dimZ, m_size;
     CompFab::Vec3 m_lowerLeft;
+    bool m_ownsArray;
 
 } AccessibilityGrid;
 
@@ -67,6 +176,17 @@ class VoxelSort {
 };
 
 void printList(std::vector<Voxel> list);
+void printList(Neighbors list);
+void printList(const Piece & list);
+Neighbors getNeighbors(Voxel voxel, CompFab::VoxelGrid * voxel_list, int pieceId);
+void buildRayIndex( CompFab::VoxelGrid * voxel_list );
+void buildRemainderOracle( CompFab::VoxelGrid * voxel_list );
+void buildScorePrefix( CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores );
+void setVoxelLabel( CompFab::VoxelGrid * voxel_list, Voxel voxel, unsigned int label);
+Voxel nearestAlongRay( CompFab::VoxelGrid * voxel_list, Voxel from, Voxel dir, int label);
+Voxel farthestAlongRay( CompFab::VoxelGrid * voxel_list, Voxel from, Voxel dir, int label);
+int countAlongRay( CompFab::VoxelGrid * voxel_list, Voxel from, Voxel dir, int label);
+void collectAlongRay( CompFab::VoxelGrid * voxel_list, Voxel from, Voxel dir, int label, std::vector<Voxel> * out);
 std::vector<Voxel> findSeeds( CompFab::VoxelGrid * voxel_list );
 unsigned int countNeighbors( CompFab::VoxelGrid * voxel_list, Voxel voxel);
 AccessibilityGrid * accessibilityScores( CompFab::VoxelGrid * voxel_list, double alpha, unsigned int recurse, int pieceId);
@@ -82,13 +202,15 @@ std::vector<Voxel> filterKey(CompFab::VoxelGrid * voxel_list,
                             int * index);
 std::vector<Voxel> findAnchors(CompFab::VoxelGrid * voxel_list, Voxel seed, Voxel normal_one, Voxel normal_two);
 Voxel finalAnchor(CompFab::VoxelGrid * voxel_list, Voxel seed, VoxelPair blocks, Voxel normal);
-std::vector<Voxel> expandPiece( CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, std::vector<Voxel> key, std::vector<Voxel> anchors, int num_voxels, Voxel normal);
-bool verifyPiece( CompFab::VoxelGrid * voxel_list, std::vector<Voxel> piece);
-Voxel findNormalDirection( CompFab::VoxelGrid * voxel_list, Voxel voxel, std::vector<Voxel> piece);
-std::vector<Voxel> findCandidateSeeds(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, std::vector<Voxel> piece, Voxel perpendicular);
-std::vector<Voxel> seedSorter(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, std::vector<Voxel> seeds, std::vector<Voxel> piece);
-std::vector<Voxel> createInitialPiece(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, std::vector<Voxel> prevPiece, std::vector<Voxel> candidates, int * index);
-std::vector<Voxel> ensureInterlocking(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, std::vector<Voxel> prevPiece, std::vector<Voxel> currentPiece, int prevPieceId, Voxel prevNormal, std::vector<Voxel> * theAnchors);
+Piece expandPiece( CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, Piece key, std::vector<Voxel> anchors, int num_voxels, Voxel normal);
+bool verifyPiece( CompFab::VoxelGrid * voxel_list, const Piece & piece);
+Voxel findNormalDirection( CompFab::VoxelGrid * voxel_list, Voxel voxel, const Piece & piece);
+std::vector<Voxel> findCandidateSeeds(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, const Piece & piece, Voxel perpendicular);
+std::vector<Voxel> seedSorter(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, std::vector<Voxel> seeds, const Piece & piece);
+Piece createInitialPiece(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, const Piece & prevPiece, std::vector<Voxel> candidates, int * index);
+Piece ensureInterlocking(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, const Piece & prevPiece, Piece currentPiece, int prevPieceId, Voxel prevNormal, std::vector<Voxel> * theAnchors);
 std::vector<Voxel> bfsTwo(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, Voxel seed, Voxel toBlock, Voxel normal, int nb_one, int nb_two, Voxel * anchor, std::vector<Voxel> anchorList);
-std::vector<Voxel> ensurePieceConnectivity(CompFab::VoxelGrid * voxel_list, std::vector<Voxel> piece, Voxel normal);
-std::vector<Voxel> partitionPiece(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, std::vector<Voxel> piece, int numPartition, int pieceSize);
+Piece ensurePieceConnectivity(CompFab::VoxelGrid * voxel_list, Piece piece, Voxel normal);
+Piece partitionPiece(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, const Piece & piece, int numPartition, int pieceSize);
+
+#endif
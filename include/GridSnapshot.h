@@ -0,0 +1,61 @@
+/**
+    CS591-W1 Final Project
+    GridSnapshot.h
+    Purpose: Headers for saving and mapping voxelized puzzles so several processes can share one copy.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#ifndef GRIDSNAPSHOT_H
+#define GRIDSNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "CompFab.h"
+#include "ExtractPartitions.h"
+
+#define GRID_SNAPSHOT_MAGIC "VOXGRID"
+#define GRID_SNAPSHOT_VERSION 1
+#define GRID_SNAPSHOT_HAS_SCORES 0x1
+
+/*
+    On-disk layout, all little endian:
+
+        [0, 128)            GridSnapshotHeader, zero padded
+        [labelOffset, ...)  dimX*dimY*dimZ unsigned 32-bit labels, VoxelGrid::isInside order
+        [scoreOffset, ...)  dimX*dimY*dimZ doubles, AccessibilityGrid::score order (optional)
+
+    Both arrays are 8-byte aligned so the mapped file can be used in place.
+*/
+typedef struct GridSnapshotHeaderStruct {
+    char m_magic[8];
+    uint32_t m_version;
+    uint32_t m_headerSize;
+    uint32_t m_dimX, m_dimY, m_dimZ;
+    uint32_t m_flags;
+    double m_spacing;
+    double m_lowerLeft[3];
+    uint64_t m_labelOffset;
+    uint64_t m_scoreOffset;
+    uint8_t m_reserved[48];
+} GridSnapshotHeader;
+
+typedef struct GridSnapshotStruct {
+    //Wraps a private mapping: pages are shared until written, then copied for this process only
+    GridSnapshotStruct(void *base, size_t length);
+    ~GridSnapshotStruct();
+
+    void *m_base;
+    size_t m_length;
+    const GridSnapshotHeader *m_header;
+    CompFab::VoxelGrid *m_grid;
+    AccessibilityGrid *m_scores;
+
+} GridSnapshot;
+
+bool isGridSnapshot(const char * filename);
+int saveGridSnapshot(std::string filename, CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores);
+GridSnapshot * mapGridSnapshot(const char * filename);
+
+#endif
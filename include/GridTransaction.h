@@ -0,0 +1,49 @@
+/**
+    CS591-W1 Final Project
+    GridTransaction.h
+    Purpose: Headers for trial edits to the voxel grid that can be tested and undone.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#ifndef GRIDTRANSACTION_H
+#define GRIDTRANSACTION_H
+
+#include <utility>
+#include <vector>
+#include "CompFab.h"
+#include "ExtractPartitions.h"
+#include "UnionFind.h"
+
+/*
+    A batch of tentative changes: relabelled voxels, and a set of voxels whose connectivity is
+    tracked by a rollback union-find as they are included. rollback() puts the labels back through
+    setVoxelLabel, undoes the unions, and restores the remainder oracle to where it stood when the
+    transaction began, so nothing has to be rebuilt after an abandoned trial. Each undo is O(1) per
+    change. Changes stand unless rolled back; commit() makes the current state the new starting
+    point. While a transaction is open, labels must only change through it.
+*/
+typedef struct GridTransactionStruct {
+    GridTransactionStruct(CompFab::VoxelGrid * voxel_list);
+
+    void relabel(const Voxel & voxel, unsigned int label);
+    void include(const Voxel & voxel);
+    //The number of connected components among the included voxels
+    inline unsigned int components() const { return m_sets.components(); }
+    bool connected(const Voxel & a, const Voxel & b) const;
+
+    void rollback();
+    void commit();
+
+    CompFab::VoxelGrid *m_grid;
+    RollbackUnionFind m_sets;
+    //Each relabelled voxel with the label it had before
+    std::vector<std::pair<Voxel, unsigned int> > m_labels;
+    //The remainder oracle's state when the transaction began
+    bool m_oracleKnown;
+    bool m_oracleConnected;
+    std::vector<Voxel> m_oracleRemoved;
+
+} GridTransaction;
+
+#endif
@@ -0,0 +1,68 @@
+/**
+    CS591-W1 Final Project
+    Parallel.h
+    Purpose: Headers for splitting grid-wide work across threads.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+//Grids smaller than this are worked on by the calling thread alone unless asked otherwise
+#define PARALLEL_MIN_CELLS (1u << 16)
+
+/**
+    The number of threads grid-wide work is split across by default.
+
+    @return The number of hardware threads, at least one.
+*/
+inline unsigned int workerCount() {
+    unsigned int count = std::thread::hardware_concurrency();
+    return count == 0 ? 1 : count;
+}
+
+/**
+    Picks how many slabs to split a grid into for parallelRanges.
+
+    @param cells The number of cells in the grid.
+    @param slices The number of z slices in the grid.
+    @param threads The number of threads asked for, or 0 to pick from the grid size.
+    @return The number of slabs, between 1 and slices.
+*/
+inline unsigned int slabCount(unsigned int cells, unsigned int slices, unsigned int threads) {
+    if (threads == 0) {
+        threads = cells < PARALLEL_MIN_CELLS ? 1 : workerCount();
+    }
+    return std::max(1u, std::min(threads, slices));
+}
+
+/**
+    Splits [0, count) into contiguous ranges of nearly equal size and runs work(part, begin, end)
+    on each. The first range runs on the calling thread and every other one on its own thread.
+    Returns once every range is done, so consecutive calls act as a barrier between phases.
+
+    @param count The number of items, usually z slices of the grid.
+    @param parts The number of ranges. Clamped to [1, count].
+    @param work The work to run on each range.
+*/
+template <typename Work>
+void parallelRanges(unsigned int count, unsigned int parts, Work work) {
+    parts = std::max(1u, std::min(parts, count));
+    std::vector<std::thread> threads;
+    for (unsigned int part = 1; part < parts; part++) {
+        unsigned int begin = (unsigned long long)count*part/parts;
+        unsigned int end = (unsigned long long)count*(part + 1)/parts;
+        threads.push_back(std::thread(work, part, begin, end));
+    }
+    work(0u, 0u, (unsigned int)((unsigned long long)count/parts));
+    for (int i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+}
+
+#endif
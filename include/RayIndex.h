@@ -0,0 +1,48 @@
+/**
+    CS591-W1 Final Project
+    RayIndex.h
+    Purpose: Headers for answering axis-aligned ray queries over the voxels of one label.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#ifndef RAYINDEX_H
+#define RAYINDEX_H
+
+#include <cstdint>
+#include <vector>
+#include "CompFab.h"
+#include "ExtractPartitions.h"
+#include "Direction.h"
+
+/*
+    Every axis-aligned line of the grid is kept as a bitset of the cells holding m_label, once per
+    axis. Nearest/farthest/count along a ray are then a handful of word operations on one line
+    (dim/64 words) instead of a march of up to dim cells, and a label change flips three bits.
+*/
+typedef struct RayIndexStruct {
+    RayIndexStruct(CompFab::VoxelGrid * voxel_list, unsigned int label);
+
+    void update(const Voxel & voxel, bool occupied);
+    bool occupied(const Voxel & voxel) const;
+    Voxel nearest(const Voxel & from, Direction dir) const;
+    Voxel farthest(const Voxel & from, Direction dir) const;
+    int count(const Voxel & from, Direction dir) const;
+
+    //Offset of the first word of the line through voxel along axis
+    inline size_t lineOffset(int axis, const Voxel & voxel) const {
+        int a = (axis + 1) % 3;
+        int b = (axis + 2) % 3;
+        int coord[3] = {voxel.x, voxel.y, voxel.z};
+        return ((size_t)coord[b]*m_dim[a] + coord[a])*m_words[axis];
+    }
+
+    CompFab::VoxelGrid *m_grid;
+    unsigned int m_label;
+    int m_dim[3];
+    unsigned int m_words[3];
+    std::vector<uint64_t> m_lines[3];
+
+} RayIndex;
+
+#endif
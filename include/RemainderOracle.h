@@ -0,0 +1,56 @@
+/**
+    CS591-W1 Final Project
+    RemainderOracle.h
+    Purpose: Headers for answering whether taking voxels out of the unassigned remainder disconnects it.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#ifndef REMAINDERORACLE_H
+#define REMAINDERORACLE_H
+
+#include <vector>
+#include "CompFab.h"
+#include "ExtractPartitions.h"
+#include "BitVolume.h"
+
+/*
+    Keeps the unassigned (label 1) voxels and whether they form one connected region, updated by
+    setVoxelLabel as voxels are assigned.
+
+    While the remainder is known to be connected, every region left after taking a set of voxels
+    out of it touches that set. So the question only needs a search from the voxels bordering the
+    set: one region per bordering voxel, grown level by level and merged where they meet. The answer
+    is yes once a single region is left, and no as soon as some region runs out of voxels to grow
+    into. That usually takes time in proportion to the size of the set rather than the volume.
+    Searches that grow past a budget, and remainders that are not connected to begin with, fall
+    back to a bit-parallel flood fill of the whole remainder.
+
+    Assigned voxels are remembered until the next query, which checks them the same way to keep the
+    connected flag current. Voxels being unassigned again make the next query recompute it.
+*/
+typedef struct RemainderOracleStruct {
+    RemainderOracleStruct(CompFab::VoxelGrid * voxel_list);
+
+    void update(const Voxel & voxel, bool unassigned);
+    bool connected();
+    bool staysConnected(const Piece & piece);
+
+    CompFab::VoxelGrid *m_grid;
+    BitVolume m_unassigned;
+    unsigned int m_count;
+    //Whether m_connected is known for the remainder plus m_removed
+    bool m_known;
+    bool m_connected;
+    //Voxels assigned since m_connected was last brought up to date
+    std::vector<Voxel> m_removed;
+    //Queries answered by a local search and by a full flood fill
+    unsigned long long m_localChecks;
+    unsigned long long m_fullChecks;
+
+} RemainderOracle;
+
+//The oracle verifyPiece uses, built by buildRemainderOracle
+extern RemainderOracle * g_remainderOracle;
+
+#endif
@@ -0,0 +1,58 @@
+/**
+    CS591-W1 Final Project
+    ScorePrefix.h
+    Purpose: Headers for summing accessibility scores along axis-aligned runs in constant time.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#ifndef SCOREPREFIX_H
+#define SCOREPREFIX_H
+
+#include <cstdint>
+#include <vector>
+#include "CompFab.h"
+#include "ExtractPartitions.h"
+#include "Direction.h"
+
+/*
+    Running sums of the scores of the voxels holding m_label, along every axis-aligned line of the
+    grid, once per axis and numbered the same way as RayIndex lines. The sum over the labelled
+    voxels of any run of a line, such as everything collectAlongRay would return, is then the
+    difference of two entries.
+
+    A line is rebuilt the next time it is read after a voxel on it changes label or score;
+    setVoxelLabel and the accessibility engine report those. Sums are taken in increasing
+    coordinate order, so a run's sum can differ in its last bits from adding its voxels in ray
+    order.
+*/
+typedef struct ScorePrefixStruct {
+    ScorePrefixStruct(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, unsigned int label);
+
+    void touch(const Voxel & voxel);
+    void touchAll();
+    double runSum(const Voxel & from, Direction dir);
+
+    //Line through voxel along axis
+    inline unsigned int line(int axis, const Voxel & voxel) const {
+        int coord[3] = {voxel.x, voxel.y, voxel.z};
+        return coord[(axis + 2) % 3]*m_dim[(axis + 1) % 3] + coord[(axis + 1) % 3];
+    }
+
+    CompFab::VoxelGrid *m_grid;
+    AccessibilityGrid *m_scores;
+    unsigned int m_label;
+    int m_dim[3];
+    //m_dim[axis] + 1 running sums per line, starting from 0
+    std::vector<double> m_sums[3];
+    //Lines to rebuild before they are next read
+    std::vector<uint8_t> m_dirty[3];
+    //Lines rebuilt so far
+    unsigned long long m_rebuilt;
+
+} ScorePrefix;
+
+//The sums expandPiece reads, built by buildScorePrefix
+extern ScorePrefix * g_scorePrefix;
+
+#endif
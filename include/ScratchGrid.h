@@ -0,0 +1,106 @@
+/**
+    CS591-W1 Final Project
+    ScratchGrid.h
+    Purpose: Headers for reusable per-thread visited marks over the voxel grid.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#ifndef SCRATCHGRID_H
+#define SCRATCHGRID_H
+
+#include <cstdint>
+#include <vector>
+
+/*
+    First in, first out queue of linear voxel indices in a power-of-two ring buffer. Capacity is
+    kept when the queue is cleared, so a queue that lives in a pooled ScratchGrid stops allocating
+    once it has grown to the largest frontier seen.
+*/
+typedef struct IndexQueueStruct {
+    IndexQueueStruct() : m_head(0), m_count(0) {}
+
+    inline bool empty() const { return m_count == 0; }
+    inline unsigned int size() const { return m_count; }
+    inline uint32_t front() const { return m_ring[m_head]; }
+    inline void pop() {
+        m_head = (m_head + 1) & (m_ring.size() - 1);
+        m_count--;
+    }
+    inline void push(uint32_t index) {
+        if (m_count == m_ring.size()) {
+            grow();
+        }
+        m_ring[(m_head + m_count) & (m_ring.size() - 1)] = index;
+        m_count++;
+    }
+    inline void clear() {
+        m_head = 0;
+        m_count = 0;
+    }
+    void grow();
+
+    std::vector<uint32_t> m_ring;
+    unsigned int m_head;
+    unsigned int m_count;
+
+} IndexQueue;
+
+/*
+    A cell is marked when its stamp equals the current epoch, so clearing every mark is a single
+    increment of the epoch instead of a pass over the grid. The stamps are only zeroed when the
+    array grows or the epoch wraps around.
+*/
+typedef struct ScratchGridStruct {
+    ScratchGridStruct();
+
+    void reset(unsigned int size);
+
+    inline bool marked(unsigned int i) const { return m_stamp[i] == m_epoch; }
+    inline void mark(unsigned int i) { m_stamp[i] = m_epoch; }
+    inline void unmark(unsigned int i) { m_stamp[i] = m_epoch - 1; }
+
+    //Marks a cell, returning true if it wasn't marked before
+    inline bool testAndMark(unsigned int i) {
+        if (m_stamp[i] == m_epoch) {
+            return false;
+        }
+        m_stamp[i] = m_epoch;
+        return true;
+    }
+
+    //Per-cell payload, e.g. a BFS parent. Only meaningful for cells marked this epoch
+    inline uint32_t & value(unsigned int i) { return m_value[i]; }
+    void reserveValues();
+
+    std::vector<uint32_t> m_stamp;
+    std::vector<uint32_t> m_value;
+    //Queue for a search over this grid's marks, emptied by reset
+    IndexQueue m_queue;
+    uint32_t m_epoch;
+
+} ScratchGrid;
+
+ScratchGrid * acquireScratch(unsigned int size);
+void releaseScratch(ScratchGrid * scratch);
+
+/*
+    Borrows a cleared ScratchGrid from the calling thread's pool for the lifetime of the lease.
+    Leases nest, so a routine holding one can call another that takes its own.
+*/
+typedef struct ScratchLeaseStruct {
+    ScratchLeaseStruct(unsigned int size) : m_scratch(acquireScratch(size)) {}
+    ~ScratchLeaseStruct() { releaseScratch(m_scratch); }
+
+    inline ScratchGrid * operator->() const { return m_scratch; }
+    inline ScratchGrid & operator*() const { return *m_scratch; }
+
+    ScratchGrid *m_scratch;
+
+  private:
+    ScratchLeaseStruct(const ScratchLeaseStruct &);
+    ScratchLeaseStruct & operator=(const ScratchLeaseStruct &);
+
+} ScratchLease;
+
+#endif
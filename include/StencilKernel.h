@@ -0,0 +1,27 @@
+/**
+    CS591-W1 Final Project
+    StencilKernel.h
+    Purpose: Headers for the vectorized accessibility stencil, picked at run time.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#ifndef STENCILKERNEL_H
+#define STENCILKERNEL_H
+
+#include <cstdint>
+#include "CompFab.h"
+
+//Which instructions stencilLevel runs on
+enum StencilMode { STENCIL_SCALAR = 0, STENCIL_SSE2 = 1, STENCIL_AVX2 = 2 };
+#define STENCIL_MODE_COUNT 3
+
+//Starts as the best mode the processor supports; lowering it is always safe
+extern StencilMode g_stencilMode;
+
+StencilMode bestStencilMode();
+const char * stencilModeName(StencilMode mode);
+void stencilLevel(CompFab::VoxelGrid * voxel_list, const uint8_t * neighbors, const double * below, double multiplier, double * level,
+                  unsigned int threads = 0);
+
+#endif
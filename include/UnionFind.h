@@ -0,0 +1,58 @@
+/**
+    CS591-W1 Final Project
+    UnionFind.h
+    Purpose: Headers for a disjoint-set forest over grid cells whose changes can be undone.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#ifndef UNIONFIND_H
+#define UNIONFIND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ScratchGrid.h"
+
+/*
+    Union by rank without path compression, so find takes O(log n) steps and every change is a
+    single parent or rank write that the log can put back. Cells join the structure one at a time,
+    and rolling back to a checkpoint undoes each add and union made since in O(1).
+
+    Membership and parents live in leased scratch grids, so starting an empty structure over the
+    whole grid costs nothing beyond the lease.
+*/
+typedef struct RollbackUnionFindStruct {
+    RollbackUnionFindStruct(unsigned int size);
+
+    inline bool contains(unsigned int i) const { return m_parent->marked(i); }
+    inline unsigned int find(unsigned int i) const {
+        while (m_parent->value(i) != i) {
+            i = m_parent->value(i);
+        }
+        return i;
+    }
+    void add(unsigned int i);
+    bool unite(unsigned int a, unsigned int b);
+    inline unsigned int components() const { return m_components; }
+
+    inline size_t checkpoint() const { return m_log.size(); }
+    void rollback(size_t checkpoint);
+    //Keeps every change made so far; later rollbacks stop here
+    inline void commit() { m_log.clear(); }
+
+    //Marks the cells in the structure, with each one's parent as its value
+    ScratchLease m_parent;
+    ScratchLease m_rank;
+    unsigned int m_components;
+    //Each entry undoes one change: an added cell, or a root attached under another
+    struct Change {
+        uint32_t cell;
+        uint32_t root;
+        bool grewRank;
+    };
+    std::vector<Change> m_log;
+
+} RollbackUnionFind;
+
+#endif
@@ -0,0 +1,113 @@
+/**
+    CS591-W1 Final Project
+    VoxelSearch.h
+    Purpose: Headers for the breadth first path searches over the voxels of one label.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#ifndef VOXELSEARCH_H
+#define VOXELSEARCH_H
+
+#include <vector>
+#include "CompFab.h"
+#include "ExtractPartitions.h"
+#include "ScratchGrid.h"
+
+//Parent value of a forbidden cell
+#define VOXEL_SEARCH_FORBIDDEN 0xFFFFFFFFu
+
+//How pointPath answers point to point queries. Only PATH_BFS breaks ties between equally short
+//paths the way the tree searches do, so the other modes can change the generated puzzles
+enum PathMode { PATH_BFS = 0, PATH_BIDIRECTIONAL = 1, PATH_ASTAR = 2 };
+#define PATH_MODE_COUNT 3
+
+//PATH_BFS unless a caller opts into another mode
+extern PathMode g_pathMode;
+//Cells expanded by every search so far, by the kind of search. Tree searches count as PATH_BFS
+extern unsigned long long g_searchExpansions[PATH_MODE_COUNT];
+
+/*
+    Breadth first search that records each reached cell's parent in a leased scratch grid rather
+    than queueing whole paths, so a search costs O(cells reached) and only the path to the goal is
+    ever built. Cells can be forbidden before searching; they are treated as already visited.
+    Neighbors are expanded in forEachNeighbor order, so the path found is the same one a
+    path-copying search would find.
+
+    Point to point queries can instead search from both ends (bidirectionalPath) or toward the
+    goal (aStarPath); pointPath picks one according to g_pathMode.
+
+    The search can also be kept as a tree rooted at one voxel: reach() expands it only as far as
+    needed to discover a target and keeps what it expanded, so paths to many targets from the same
+    root share a single search.
+*/
+typedef struct VoxelSearchStruct {
+    VoxelSearchStruct(CompFab::VoxelGrid * voxel_list, int label);
+
+    void forbid(const Voxel & voxel);
+    void forbid(const std::vector<Voxel> & voxels);
+
+    template <typename Goal>
+    std::vector<Voxel> shortestPath(const Voxel & start, Goal isGoal);
+
+    void root(const Voxel & start);
+    bool reach(const Voxel & target);
+    unsigned int depth(const Voxel & voxel);
+
+    std::vector<Voxel> pointPath(const Voxel & start, const Voxel & goal);
+    std::vector<Voxel> bidirectionalPath(const Voxel & start, const Voxel & goal);
+    std::vector<Voxel> aStarPath(const Voxel & start, const Voxel & goal);
+
+    std::vector<Voxel> pathTo(unsigned int index);
+    std::vector<Voxel> pathTo(const Voxel & voxel);
+
+    CompFab::VoxelGrid *m_grid;
+    int m_label;
+    ScratchLease m_visited;
+    //Cells discovered by the tree, with their depth; unlike m_visited, excludes forbidden cells.
+    //bidirectionalPath uses it for the search from the goal, with parents toward the goal, and
+    //aStarPath for the best known distance from the start
+    ScratchLease m_reached;
+    std::vector<Voxel> m_queue;
+    unsigned int m_head;
+    //Cells expanded by this search
+    unsigned long long m_expanded;
+
+} VoxelSearch;
+
+/**
+    Searches from start until isGoal(voxel, index) holds for a dequeued cell.
+
+    @param start The voxel the search starts from. It must not be forbidden.
+    @param isGoal The goal test, called on each cell as it is dequeued, start included.
+    @return The path from start to the first goal reached, or an empty list if none is reachable.
+*/
+template <typename Goal>
+std::vector<Voxel> VoxelSearchStruct::shortestPath(const Voxel & start, Goal isGoal) {
+    unsigned int startIndex = voxelIndex(m_grid, start);
+    m_visited->mark(startIndex);
+    m_visited->value(startIndex) = startIndex;
+    m_queue.clear();
+    m_queue.push_back(start);
+
+    for (unsigned int head = 0; head < m_queue.size(); head++) {
+        Voxel current = m_queue[head];
+        m_expanded++;
+        g_searchExpansions[PATH_BFS]++;
+        unsigned int index = voxelIndex(m_grid, current);
+        if (isGoal(current, index)) {
+            return pathTo(index);
+        }
+        ScratchGrid & visited = *m_visited;
+        std::vector<Voxel> & queue = m_queue;
+        forEachNeighbor(m_grid, current, m_label, [&](const Voxel & next, unsigned int nextIndex) {
+            if (visited.testAndMark(nextIndex)) {
+                visited.value(nextIndex) = index;
+                queue.push_back(next);
+            }
+        });
+    }
+    return std::vector<Voxel>();
+}
+
+#endif
@@ -0,0 +1,56 @@
+/**
+    CS591-W1 Final Project
+    WeightSampler.h
+    Purpose: Headers for drawing weighted random choices from a changing set of slots.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#ifndef WEIGHTSAMPLER_H
+#define WEIGHTSAMPLER_H
+
+#include <vector>
+#include <cfloat>
+
+//Largest weight a slot holds, so that the weights of 2^32 slots still sum to a finite total
+#define WEIGHT_SAMPLER_MAX (DBL_MAX / 4294967296.0)
+
+/*
+    A Fenwick tree over slot weights. Adding a slot, changing its weight and drawing a slot with
+    probability proportional to its weight each take O(log n); a slot is removed by setting its
+    weight to 0, which it then never gets drawn with. Slots keep their numbers until clear.
+
+    Weight changes are applied as differences, so the tree is rebuilt from the exact weights once
+    there have been as many changes as slots, before rounding can build up.
+
+    Weights are clamped as they come in: NaN and negative weights count as 0, and weights above
+    WEIGHT_SAMPLER_MAX (+inf included) as WEIGHT_SAMPLER_MAX. An infinite weight therefore makes a
+    slot all but certain to be drawn, shared evenly with any other such slots, instead of turning
+    the sums into NaN. Taking a slot off the cap rebuilds the tree, since subtracting the cap from
+    the sums would leave rounding error far larger than the remaining weights.
+*/
+typedef struct WeightSamplerStruct {
+    WeightSamplerStruct();
+
+    void clear();
+    void assign(const std::vector<double> & weights);
+    unsigned int add(double weight);
+    void set(unsigned int slot, double weight);
+    double prefix(unsigned int slots) const;
+    int draw(double random) const;
+
+    inline unsigned int size() const { return m_weights.size(); }
+    inline double weight(unsigned int slot) const { return m_weights[slot]; }
+    inline double total() const { return prefix(m_weights.size()); }
+
+    void rebuild();
+
+    std::vector<double> m_weights;
+    //1-based; entry i holds the sum of the (i & -i) weights ending at slot i - 1
+    std::vector<double> m_tree;
+    //Weight changes since the tree was last built
+    unsigned int m_changes;
+
+} WeightSampler;
+
+#endif
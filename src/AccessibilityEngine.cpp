@@ -0,0 +1,169 @@
+/**
+    CS591-W1 Final Project
+    AccessibilityEngine.cpp
+    Purpose: For keeping accessibility scores current as voxels change label.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#include <vector>
+#include <cmath>
+#include "../include/AccessibilityEngine.h"
+#include "../include/ScratchGrid.h"
+#include "../include/Direction.h"
+#include "../include/ScorePrefix.h"
+#include "../include/AccessibilityScorer.h"
+#include "../include/StencilKernel.h"
+
+AccessibilityEngine * g_accessibility = NULL;
+
+/**
+    Scores one cell at one level of the recursion, exactly as accessibilityScores does, for
+    refreshes that only revisit a few cells.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param levels The scores of every level, with the levels below this one current.
+    @param level The level to score.
+    @param multiplier alpha raised to the level.
+    @param label The label being scored.
+    @param index The linear index of the cell.
+    @return The cell's score at that level.
+*/
+static double levelScore( CompFab::VoxelGrid * voxel_list, const std::vector<std::vector<double> > & levels, unsigned int level,
+                          double multiplier, int label, unsigned int index) {
+    if (level == 0) {
+        double count = 0;
+        forEachNeighbor(voxel_list, voxelAt(voxel_list, index), label, [&count](const Voxel & neighbor, unsigned int next) {
+            count++;
+        });
+        return count;
+    }
+    const double *old_array = levels[level - 1].data();
+    double current_score = 0;
+    forEachNeighbor(voxel_list, voxelAt(voxel_list, index), label, [&current_score, old_array](const Voxel & neighbor, unsigned int next) {
+        current_score += old_array[next];
+    });
+    current_score *= multiplier;
+    current_score += old_array[index];
+    return current_score;
+}
+
+/**
+    Constructor for the AccessibilityEngineStruct class. Scores every cell at every level, with
+    the same mask pass and stencil kernels as AccessibilityScorer, split into z slabs the same way,
+    so the scores match it bit for bit.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param alpha A double used as a param for how to generate the scores.
+    @param recurse How many layers of recursion to perform in score generation.
+    @param pieceId The id of the piece we are scoring. Is usually 1.
+    @param threads The number of threads to score with, or 0 to pick from the grid size.
+*/
+AccessibilityEngineStruct::AccessibilityEngineStruct(CompFab::VoxelGrid * voxel_list, double alpha, unsigned int recurse, int pieceId,
+                                                     unsigned int threads)
+    : m_levels(recurse + 1, std::vector<double>(voxel_list->m_size)),
+      m_scores(CompFab::Vec3(0.0, 0.0, 0.0), voxel_list->m_dimX, voxel_list->m_dimY, voxel_list->m_dimZ, m_levels.back().data()),
+      m_pending(voxel_list->m_size, false) {
+    m_grid = voxel_list;
+    m_alpha = alpha;
+    m_recurse = recurse;
+    m_label = pieceId;
+    m_recomputed = 0;
+    AccessibilityScorer scorer(threads);
+    unsigned int slabs = scorer.buildMasks(voxel_list, pieceId, false, m_levels[0].data());
+    for (unsigned int r = 1; r <= recurse; r++) {
+        stencilLevel(voxel_list, scorer.m_neighbors.data(), m_levels[r - 1].data(), pow(alpha, r), m_levels[r].data(), slabs);
+    }
+}
+
+/**
+    Records that a voxel changed to or from the scored label. Called by setVoxelLabel.
+
+    @param voxel The voxel.
+*/
+void AccessibilityEngineStruct::touch(const Voxel & voxel) {
+    unsigned int index = voxelIndex(m_grid, voxel);
+    if (!m_pending[index]) {
+        m_pending[index] = true;
+        m_changed.push_back(index);
+    }
+}
+
+/**
+    Brings the scores up to date with every label change recorded since the last refresh. Level r
+    is recomputed over the cells within r+1 steps of a changed voxel, growing the region by one
+    step of face neighbors, whatever their label, before each level.
+
+    @return The top level scores, owned by the engine.
+*/
+AccessibilityGrid * AccessibilityEngineStruct::refresh() {
+    if (m_changed.empty()) {
+        return &m_scores;
+    }
+    const int dimX = m_grid->m_dimX;
+    const int dimY = m_grid->m_dimY;
+    const int dimZ = m_grid->m_dimZ;
+    ScratchLease region(m_grid->m_size);
+    std::vector<uint32_t> cells;
+    for (int i = 0; i < m_changed.size(); i++) {
+        region->mark(m_changed[i]);
+        cells.push_back(m_changed[i]);
+        m_pending[m_changed[i]] = false;
+    }
+    m_changed.clear();
+
+    unsigned int grown = 0;
+    for (unsigned int level = 0; level <= m_recurse; level++) {
+        unsigned int end = cells.size();
+        for (unsigned int c = grown; c < end; c++) {
+            Voxel voxel = voxelAt(m_grid, cells[c]);
+            for (int d = NEG_X; d < NO_DIRECTION; d++) {
+                Voxel next = voxel + directionVoxel((Direction)d);
+                if (next.x < 0 || next.x >= dimX || next.y < 0 || next.y >= dimY || next.z < 0 || next.z >= dimZ) {
+                    continue;
+                }
+                unsigned int index = voxelIndex(m_grid, next);
+                if (region->testAndMark(index)) {
+                    cells.push_back(index);
+                }
+            }
+        }
+        grown = end;
+
+        double multiplier = pow(m_alpha, level);
+        std::vector<double> & scores = m_levels[level];
+        for (unsigned int c = 0; c < cells.size(); c++) {
+            scores[cells[c]] = levelScore(m_grid, m_levels, level, multiplier, m_label, cells[c]);
+        }
+        m_recomputed += cells.size();
+    }
+    if (g_scorePrefix != NULL && g_scorePrefix->m_scores == &m_scores) {
+        for (unsigned int c = 0; c < cells.size(); c++) {
+            g_scorePrefix->touch(voxelAt(m_grid, cells[c]));
+        }
+    }
+    return &m_scores;
+}
+
+/**
+    Finds the accessibility scores of a VoxelGrid, like accessibilityScores, from an engine that
+    is kept between calls. The first call, and any call with different parameters, scores the whole
+    grid; later ones only refresh around the voxels that changed label since.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param alpha A double used as a param for how to generate the scores.
+    @param recurse How many layers of recursion to perform in score generation.
+    @param pieceId The id of the piece we are scoring. Is usually 1.
+    @return The scores, owned by the engine and valid until the next call.
+*/
+AccessibilityGrid * currentAccessibility( CompFab::VoxelGrid * voxel_list, double alpha, unsigned int recurse, int pieceId) {
+    if (g_accessibility == NULL || !g_accessibility->matches(voxel_list, alpha, recurse, pieceId)) {
+        if (g_scorePrefix != NULL && g_accessibility != NULL && g_scorePrefix->m_scores == &g_accessibility->m_scores) {
+            // The new engine's scores may land at the same address
+            g_scorePrefix->touchAll();
+        }
+        delete g_accessibility;
+        g_accessibility = new AccessibilityEngine(voxel_list, alpha, recurse, pieceId);
+    }
+    return g_accessibility->refresh();
+}
@@ -0,0 +1,126 @@
+/**
+    CS591-W1 Final Project
+    AccessibilityScorer.cpp
+    Purpose: For scoring accessibility level by level in reused buffers.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#include <vector>
+#include <cmath>
+#include "../include/AccessibilityScorer.h"
+#include "../include/Direction.h"
+#include "../include/StencilKernel.h"
+#include "../include/Parallel.h"
+
+/**
+    Constructor for the AccessibilityScorerStruct class. Buffers grow on the first call to score.
+
+    @param threads The number of threads to score with, or 0 to pick from the grid size.
+*/
+AccessibilityScorerStruct::AccessibilityScorerStruct(unsigned int threads) {
+    m_threads = threads;
+}
+
+/**
+    Finds the accessibility scores of a VoxelGrid, like accessibilityScores. Both the neighbor
+    masks and every level are split into z slabs across threads, with each level finished before
+    the next starts; the scores are the same for any number of threads.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param alpha A double used as a param for how to generate the scores.
+    @param recurse How many layers of recursion to perform in score generation.
+    @param pieceId The id of the piece we are scoring.
+    @param scores Where to write the scores, one per cell in voxelIndex order.
+*/
+void AccessibilityScorerStruct::score(CompFab::VoxelGrid * voxel_list, double alpha, unsigned int recurse, int pieceId, double * scores) {
+    scoreMatching(voxel_list, alpha, recurse, pieceId, false, scores);
+}
+
+/**
+    Finds, for every cell, its accessibility score for its own label, in one pass for all labels.
+
+    Only neighbors holding the scored label count, so a cell's score for its own label only needs
+    its same-label neighbors' scores for that label, which are their own-label scores too. Scoring
+    against "the cell's own label" is then a single stencil over same-label neighbor masks, and
+    each cell gets exactly the score accessibilityScores gives it for its label.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param alpha A double used as a param for how to generate the scores.
+    @param recurse How many layers of recursion to perform in score generation.
+    @param scores Where to write the scores, one per cell in voxelIndex order.
+*/
+void AccessibilityScorerStruct::scoreOwnLabels(CompFab::VoxelGrid * voxel_list, double alpha, unsigned int recurse, double * scores) {
+    scoreMatching(voxel_list, alpha, recurse, 0, true, scores);
+}
+
+/**
+    Scores every cell, counting the neighbors that hold either one label or the cell's own.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param alpha A double used as a param for how to generate the scores.
+    @param recurse How many layers of recursion to perform in score generation.
+    @param pieceId The label neighbors must hold, unless ownLabel.
+    @param ownLabel Whether neighbors must hold the cell's own label instead.
+    @param scores Where to write the scores, one per cell in voxelIndex order.
+*/
+void AccessibilityScorerStruct::scoreMatching(CompFab::VoxelGrid * voxel_list, double alpha, unsigned int recurse, int pieceId, bool ownLabel,
+                                              double * scores) {
+    m_buffer.resize(voxel_list->m_size);
+    // Level 0 lands in the buffer the top level is written to when recurse is even
+    double *level = recurse % 2 == 0 ? scores : m_buffer.data();
+    double *below = recurse % 2 == 0 ? m_buffer.data() : scores;
+    const unsigned int slabs = buildMasks(voxel_list, pieceId, ownLabel, level);
+
+    for (unsigned int r = 1; r <= recurse; r++) {
+        std::swap(level, below);
+        double multiplier = pow(alpha, r);
+        stencilLevel(voxel_list, m_neighbors.data(), below, multiplier, level, slabs);
+    }
+}
+
+/**
+    Finds each cell's neighbors holding either one label or the cell's own, kept in m_neighbors,
+    and writes their count, which is level 0 of the recursion.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param pieceId The label neighbors must hold, unless ownLabel.
+    @param ownLabel Whether neighbors must hold the cell's own label instead.
+    @param level Where to write the level 0 scores, one per cell in voxelIndex order.
+    @return The number of z slabs the pass was split into, for the levels that follow.
+*/
+unsigned int AccessibilityScorerStruct::buildMasks(CompFab::VoxelGrid * voxel_list, int pieceId, bool ownLabel, double * level) {
+    const unsigned int size = voxel_list->m_size;
+    m_neighbors.resize(size);
+    const int strides[6] = { directionStride<NEG_X>(voxel_list), directionStride<POS_X>(voxel_list),
+                             directionStride<NEG_Y>(voxel_list), directionStride<POS_Y>(voxel_list),
+                             directionStride<NEG_Z>(voxel_list), directionStride<POS_Z>(voxel_list) };
+
+    const unsigned int *labels = voxel_list->m_insideArray;
+    const unsigned int label = (unsigned int)pieceId;
+    const int dimX = voxel_list->m_dimX;
+    const int dimY = voxel_list->m_dimY;
+    const int dimZ = voxel_list->m_dimZ;
+    uint8_t *masks = m_neighbors.data();
+    const unsigned int slabs = slabCount(size, dimZ, m_threads);
+    parallelRanges(dimZ, slabs, [&](unsigned int slab, unsigned int zBegin, unsigned int zEnd) {
+        for (int z = zBegin; z < (int)zEnd; z++) {
+            for (int y = 0; y < dimY; y++) {
+                unsigned int i = voxelIndex(voxel_list, Voxel(0, y, z));
+                // Directions whose neighbor is inside the grid for the whole row, x aside
+                uint8_t open = (y != 0) << NEG_Y | (y != dimY-1) << POS_Y | (z != 0) << NEG_Z | (z != dimZ-1) << POS_Z;
+                for (int x = 0; x < dimX; x++, i++) {
+                    uint8_t inGrid = open | (x != 0) << NEG_X | (x != dimX-1) << POS_X;
+                    const unsigned int wanted = ownLabel ? labels[i] : label;
+                    uint8_t mask = 0;
+                    for (int d = NEG_X; d < NO_DIRECTION; d++) {
+                        mask |= ((inGrid >> d) & 1 && labels[i + strides[d]] == wanted) << d;
+                    }
+                    masks[i] = mask;
+                    level[i] = __builtin_popcount(mask);
+                }
+            }
+        }
+    });
+    return slabs;
+}
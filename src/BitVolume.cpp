@@ -0,0 +1,218 @@
+/**
+    CS591-W1 Final Project
+    BitVolume.cpp
+    Purpose: For bit-packed voxel sets and word-parallel flood fill over them.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#include <vector>
+#include <algorithm>
+#include "../include/BitVolume.h"
+
+/**
+    Constructor for the BitVolumeStruct class. Starts empty.
+
+    @param dimX The dimension of x.
+    @param dimY The dimension of y.
+    @param dimZ The dimension of z.
+*/
+BitVolumeStruct::BitVolumeStruct(unsigned int dimX, unsigned int dimY, unsigned int dimZ) {
+    m_dimX = dimX;
+    m_dimY = dimY;
+    m_dimZ = dimZ;
+    m_words = (dimX + 63) / 64;
+    m_rows = dimY*dimZ;
+    m_bits.assign((size_t)m_rows*m_words, 0);
+}
+
+/**
+    Removes every voxel.
+*/
+void BitVolumeStruct::clear() {
+    std::fill(m_bits.begin(), m_bits.end(), 0);
+}
+
+/**
+    Checks whether any voxel is set.
+
+    @return true if one is, false otherwise.
+*/
+bool BitVolumeStruct::any() const {
+    for (size_t i = 0; i < m_bits.size(); i++) {
+        if (m_bits[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+    Finds the set voxel with the lowest (z, y, x).
+
+    @return The voxel, or (-1, -1, -1) if none is set.
+*/
+Voxel BitVolumeStruct::first() const {
+    for (size_t i = 0; i < m_bits.size(); i++) {
+        if (m_bits[i]) {
+            unsigned int r = i / m_words;
+            int x = (i % m_words)*64 + __builtin_ctzll(m_bits[i]);
+            return Voxel(x, r % m_dimY, r / m_dimY);
+        }
+    }
+    return Voxel(-1, -1, -1);
+}
+
+/**
+    Checks whether every voxel of another volume of the same size is set in this one.
+
+    @param other The volume to check.
+    @return true if it is a subset of this volume, false otherwise.
+*/
+bool BitVolumeStruct::covers(const BitVolumeStruct & other) const {
+    for (size_t i = 0; i < m_bits.size(); i++) {
+        if (other.m_bits[i] & ~m_bits[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+    Sets exactly the voxels of a grid that hold a label.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param label The label to load.
+    @param volume A volume the size of voxel_list.
+*/
+void loadLabel( CompFab::VoxelGrid * voxel_list, unsigned int label, BitVolume * volume) {
+    volume->clear();
+    const unsigned int *labels = voxel_list->m_insideArray;
+    for (int z = 0; z < volume->m_dimZ; z++) {
+        for (int y = 0; y < volume->m_dimY; y++) {
+            uint64_t *words = volume->rowWords(volume->row(y, z));
+            const unsigned int *cell = labels + voxelIndex(voxel_list, Voxel(0, y, z));
+            for (int x = 0; x < volume->m_dimX; x++) {
+                words[x >> 6] |= (uint64_t)(cell[x] == label) << (x & 63);
+            }
+        }
+    }
+}
+
+/**
+    Extends the seeds of one row to the whole runs of allowed bits that contain them, in both
+    directions along x. Each direction is a log-step (Kogge-Stone) fill within a word, with the
+    end bit carried into the next word.
+
+    @param allowed The allowed bits of the row.
+    @param seeds The seed bits of the row, updated in place. Must be a subset of allowed.
+    @param words The number of words in the row.
+*/
+static void fillRow(const uint64_t * allowed, uint64_t * seeds, unsigned int words) {
+    uint64_t carry = 0;
+    for (unsigned int w = 0; w < words; w++) {
+        uint64_t p = allowed[w];
+        uint64_t g = seeds[w] | (carry & p);
+        g |= p & (g << 1);  p &= p << 1;
+        g |= p & (g << 2);  p &= p << 2;
+        g |= p & (g << 4);  p &= p << 4;
+        g |= p & (g << 8);  p &= p << 8;
+        g |= p & (g << 16); p &= p << 16;
+        g |= p & (g << 32);
+        seeds[w] = g;
+        carry = g >> 63;
+    }
+    carry = 0;
+    for (unsigned int w = words; w-- > 0; ) {
+        uint64_t p = allowed[w];
+        uint64_t g = seeds[w] | ((carry << 63) & p);
+        g |= p & (g >> 1);  p &= p >> 1;
+        g |= p & (g >> 2);  p &= p >> 2;
+        g |= p & (g >> 4);  p &= p >> 4;
+        g |= p & (g >> 8);  p &= p >> 8;
+        g |= p & (g >> 16); p &= p >> 16;
+        g |= p & (g >> 32);
+        seeds[w] = g;
+        carry = g & 1;
+    }
+}
+
+/**
+    Grows a set of voxels through face neighbors inside an allowed set until it stops changing.
+
+    Rows are swept alternately forward and backward, updating in place: a row takes the bits of its
+    four neighboring rows (y and z), keeps the allowed ones and fills along x. A row is only
+    revisited while it or one of its neighboring rows changed in the current or previous sweep.
+
+    @param allowed The voxels the fill may enter.
+    @param reach The seeds, replaced by everything reachable from them. Seeds outside allowed are
+                 dropped.
+    @return The number of sweeps taken.
+*/
+unsigned int floodFill(const BitVolume & allowed, BitVolume * reach) {
+    const unsigned int words = allowed.m_words;
+    const unsigned int rows = allowed.m_rows;
+    const unsigned int dimY = allowed.m_dimY;
+    // Sweep in which each row last changed; every row starts out dirty
+    std::vector<unsigned int> changed(rows, 1);
+    std::vector<uint64_t> next(words);
+
+    for (unsigned int r = 0; r < rows; r++) {
+        uint64_t *cur = reach->rowWords(r);
+        const uint64_t *ok = allowed.rowWords(r);
+        for (unsigned int w = 0; w < words; w++) {
+            cur[w] &= ok[w];
+        }
+    }
+
+    unsigned int sweep = 1;
+    bool any = true;
+    while (any) {
+        any = false;
+        sweep++;
+        bool forward = sweep % 2 == 0;
+        for (unsigned int n = 0; n < rows; n++) {
+            unsigned int r = forward ? n : rows - 1 - n;
+            unsigned int y = r % dimY;
+            bool hasDown = y != 0;
+            bool hasUp = y != dimY - 1;
+            bool hasBack = r >= dimY;
+            bool hasFront = r + dimY < rows;
+            unsigned int dirty = changed[r];
+            if (hasDown) dirty = std::max(dirty, changed[r - 1]);
+            if (hasUp) dirty = std::max(dirty, changed[r + 1]);
+            if (hasBack) dirty = std::max(dirty, changed[r - dimY]);
+            if (hasFront) dirty = std::max(dirty, changed[r + dimY]);
+            if (dirty + 1 < sweep) {
+                continue;
+            }
+
+            const uint64_t *ok = allowed.rowWords(r);
+            uint64_t *cur = reach->rowWords(r);
+            bool grew = false;
+            for (unsigned int w = 0; w < words; w++) {
+                uint64_t bits = cur[w];
+                if (hasDown) bits |= reach->rowWords(r - 1)[w];
+                if (hasUp) bits |= reach->rowWords(r + 1)[w];
+                if (hasBack) bits |= reach->rowWords(r - dimY)[w];
+                if (hasFront) bits |= reach->rowWords(r + dimY)[w];
+                next[w] = bits & ok[w];
+                grew |= next[w] != cur[w];
+            }
+            if (!grew && changed[r] + 1 < sweep) {
+                continue;
+            }
+            fillRow(ok, &next[0], words);
+            grew = false;
+            for (unsigned int w = 0; w < words; w++) {
+                grew |= next[w] != cur[w];
+                cur[w] = next[w];
+            }
+            if (grew) {
+                changed[r] = sweep;
+                any = true;
+            }
+        }
+    }
+    return sweep - 1;
+}
@@ -0,0 +1,332 @@
+/**
+    CS591-W1 Final Project
+    BlockForest.cpp
+    Purpose: For tracking the biconnected blocks and articulation points of a set of voxels.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include "../include/BlockForest.h"
+#include "../include/ScratchGrid.h"
+
+/**
+    Finds the blocks among some live voxels of a forest and adds them to it, with Tarjan's
+    algorithm run only over the induced subgraph of those voxels.
+
+    @param forest The forest.
+    @param vertices The ids of the voxels to search.
+    @return The number of connected components among the voxels.
+*/
+static unsigned int findBlocks(BlockForest * forest, const std::vector<unsigned int> & vertices) {
+    std::vector<unsigned int> & discovered = forest->m_discovered;
+    std::vector<unsigned int> & low = forest->m_low;
+    unsigned int stamp = ++forest->m_scopeStamp;
+    for (int i = 0; i < vertices.size(); i++) {
+        forest->m_scope[vertices[i]] = stamp;
+        discovered[vertices[i]] = 0;
+    }
+
+    unsigned int time = 0;
+    unsigned int components = 0;
+    // Each frame is a voxel and the next of its neighbor slots to look at
+    std::vector<std::pair<unsigned int, unsigned int> > frames;
+    std::vector<unsigned int> open;
+    for (int i = 0; i < vertices.size(); i++) {
+        unsigned int root = vertices[i];
+        if (discovered[root] != 0) {
+            continue;
+        }
+        components++;
+        discovered[root] = low[root] = ++time;
+        frames.push_back(std::make_pair(root, 0u));
+        open.push_back(root);
+        while (!frames.empty()) {
+            unsigned int v = frames.back().first;
+            if (frames.back().second < 6) {
+                unsigned int w = forest->m_adjacent[6*v + frames.back().second++];
+                if (w == BLOCK_FOREST_NONE || !forest->m_alive[w] || forest->m_scope[w] != stamp) {
+                    continue;
+                }
+                if (discovered[w] == 0) {
+                    discovered[w] = low[w] = ++time;
+                    frames.push_back(std::make_pair(w, 0u));
+                    open.push_back(w);
+                } else {
+                    low[v] = std::min(low[v], discovered[w]);
+                }
+                continue;
+            }
+            frames.pop_back();
+            if (frames.empty()) {
+                break;
+            }
+            unsigned int parent = frames.back().first;
+            low[parent] = std::min(low[parent], low[v]);
+            if (low[v] >= discovered[parent]) {
+                // Nothing below v reaches above parent, so parent closes off a block
+                unsigned int block = forest->m_blocks.size();
+                forest->m_blocks.push_back(std::vector<unsigned int>());
+                forest->m_isDirty.push_back(0);
+                std::vector<unsigned int> & members = forest->m_blocks.back();
+                unsigned int u;
+                do {
+                    u = open.back();
+                    open.pop_back();
+                    members.push_back(u);
+                    forest->m_blocksOf[u].push_back(block);
+                } while (u != v);
+                members.push_back(parent);
+                forest->m_blocksOf[parent].push_back(block);
+            }
+        }
+        open.pop_back();
+    }
+    return components;
+}
+
+/**
+    Constructor for the BlockForestStruct class. Finds the blocks of the voxels of a set that hold
+    a label.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param voxels The voxels.
+    @param label The label of the voxels to keep. Only face neighbors with it are adjacent.
+*/
+BlockForestStruct::BlockForestStruct(CompFab::VoxelGrid * voxel_list, const Piece & voxels, unsigned int label) {
+    for (int i = 0; i < voxels.size(); i++) {
+        if (voxel_list->isInside(voxels[i].x, voxels[i].y, voxels[i].z) == label) {
+            m_cells.insert(voxels[i]);
+        }
+    }
+    m_size = m_cells.size();
+
+    ScratchLease ids(voxel_list->m_size);
+    ids->reserveValues();
+    for (int i = 0; i < m_size; i++) {
+        unsigned int index = voxelIndex(voxel_list, m_cells[i]);
+        ids->mark(index);
+        ids->value(index) = i;
+    }
+    m_adjacent.assign(6*m_size, BLOCK_FOREST_NONE);
+    for (int i = 0; i < m_size; i++) {
+        int slot = 0;
+        forEachNeighbor(voxel_list, m_cells[i], label, [&](const Voxel & next, unsigned int index) {
+            if (ids->marked(index)) {
+                m_adjacent[6*i + slot++] = ids->value(index);
+            }
+        });
+    }
+
+    m_alive.assign(m_size, 1);
+    m_blocksOf.resize(m_size);
+    m_discovered.resize(m_size);
+    m_low.resize(m_size);
+    m_scope.assign(m_size, 0);
+    m_scopeStamp = 0;
+    m_region.resize(m_size);
+    m_asked = BLOCK_FOREST_NONE;
+    m_askedSplits = 0;
+    std::vector<unsigned int> all(m_size);
+    for (int i = 0; i < m_size; i++) {
+        all[i] = i;
+    }
+    m_components = findBlocks(this, all);
+}
+
+/**
+    The id of a voxel.
+
+    @param voxel The voxel.
+    @return Its id, or BLOCK_FOREST_NONE if it isn't in the forest.
+*/
+unsigned int BlockForestStruct::id(const Voxel & voxel) const {
+    std::unordered_map<uint64_t, unsigned int>::const_iterator found = m_cells.m_position.find(Piece::key(voxel));
+    return found == m_cells.m_position.end() ? BLOCK_FOREST_NONE : found->second;
+}
+
+/**
+    Drops a block, adding its live voxels to those to search again.
+
+    @param forest The forest.
+    @param block The block.
+    @param mark The scope stamp of the voxels already added.
+    @param touched The voxels to search again.
+*/
+static void dropBlock(BlockForest * forest, unsigned int block, unsigned int mark, std::vector<unsigned int> * touched) {
+    std::vector<unsigned int> & members = forest->m_blocks[block];
+    for (int j = 0; j < members.size(); j++) {
+        unsigned int u = members[j];
+        std::vector<unsigned int> & of = forest->m_blocksOf[u];
+        *std::find(of.begin(), of.end(), block) = of.back();
+        of.pop_back();
+        if (forest->m_alive[u] && forest->m_scope[u] != mark) {
+            forest->m_scope[u] = mark;
+            touched->push_back(u);
+        }
+    }
+    std::vector<unsigned int>().swap(members);
+    forest->m_isDirty[block] = 0;
+}
+
+/**
+    Searches the dirty blocks again, replacing them with the blocks their live voxels now form.
+    A clean block with an edge between two of those voxels is searched again too, since the search
+    sees every edge among the voxels it covers; it comes back unchanged.
+
+    @param forest The forest.
+*/
+static void refresh(BlockForest * forest) {
+    // findBlocks takes the next stamp for its scope, which covers exactly these voxels
+    unsigned int mark = forest->m_scopeStamp + 1;
+    std::vector<unsigned int> touched;
+    for (int i = 0; i < forest->m_dirty.size(); i++) {
+        dropBlock(forest, forest->m_dirty[i], mark, &touched);
+    }
+    forest->m_dirty.clear();
+    for (int i = 0; i < touched.size(); i++) {
+        unsigned int u = touched[i];
+        for (int k = 0; k < 6; k++) {
+            unsigned int w = forest->m_adjacent[6*u + k];
+            if (w == BLOCK_FOREST_NONE || !forest->m_alive[w] || forest->m_scope[w] != mark) {
+                continue;
+            }
+            // Two voxels share at most one block, the one their edge is in
+            std::vector<unsigned int> & of = forest->m_blocksOf[u];
+            for (int j = 0; j < of.size(); j++) {
+                std::vector<unsigned int> & other = forest->m_blocksOf[w];
+                if (std::find(other.begin(), other.end(), of[j]) != other.end()) {
+                    dropBlock(forest, of[j], mark, &touched);
+                    break;
+                }
+            }
+        }
+    }
+    findBlocks(forest, touched);
+}
+
+/**
+    Decides from a voxel's neighborhood how many pieces its component splits into without it.
+    Each live neighbor starts a region; regions grow level by level and merge where they meet.
+
+    @param forest The forest.
+    @param v The id of a live voxel.
+    @param budget The most voxels to expand.
+    @return 0 if it has no live neighbors, 1 if the regions all merge, 2 if one runs out of room
+            while others are left, meaning 2 or more, and BLOCK_FOREST_NONE if the budget ran out.
+*/
+static unsigned int localSplits(BlockForest * forest, unsigned int v, unsigned int budget) {
+    unsigned int stamp = ++forest->m_scopeStamp;
+    std::vector<unsigned int> & seen = forest->m_scope;
+    std::vector<unsigned int> & region = forest->m_region;
+    std::vector<unsigned int> parent;
+    std::vector<unsigned int> frontier;
+    std::vector<unsigned int> queue;
+    seen[v] = stamp;
+    for (int k = 0; k < 6; k++) {
+        unsigned int w = forest->m_adjacent[6*v + k];
+        if (w != BLOCK_FOREST_NONE && forest->m_alive[w]) {
+            seen[w] = stamp;
+            region[w] = parent.size();
+            parent.push_back(parent.size());
+            frontier.push_back(1);
+            queue.push_back(w);
+        }
+    }
+    unsigned int regions = parent.size();
+    for (unsigned int head = 0; regions > 1 && head < queue.size(); head++) {
+        if (head == budget) {
+            return BLOCK_FOREST_NONE;
+        }
+        unsigned int u = queue[head];
+        unsigned int own = region[u];
+        while (parent[own] != own) {
+            own = parent[own];
+        }
+        frontier[own]--;
+        for (int k = 0; k < 6; k++) {
+            unsigned int w = forest->m_adjacent[6*u + k];
+            if (w == BLOCK_FOREST_NONE || !forest->m_alive[w] || w == v) {
+                continue;
+            }
+            if (seen[w] != stamp) {
+                seen[w] = stamp;
+                region[w] = own;
+                frontier[own]++;
+                queue.push_back(w);
+                continue;
+            }
+            unsigned int other = region[w];
+            while (parent[other] != other) {
+                other = parent[other];
+            }
+            if (other != own) {
+                parent[other] = own;
+                frontier[own] += frontier[other];
+                regions--;
+            }
+        }
+        if (frontier[own] == 0 && regions > 1) {
+            return 2;
+        }
+    }
+    return std::min(regions, 2u);
+}
+
+/**
+    The number of components a voxel's own component becomes without it, from its blocks.
+
+    @param v The id of a live voxel.
+    @return The number of blocks it is in.
+*/
+unsigned int BlockForestStruct::splits(unsigned int v) {
+    for (int i = 0; i < m_blocksOf[v].size(); i++) {
+        if (m_isDirty[m_blocksOf[v][i]]) {
+            refresh(this);
+            break;
+        }
+    }
+    return m_blocksOf[v].size();
+}
+
+/**
+    Checks whether the forest would still be one connected component without a voxel.
+
+    @param v The id of a live voxel.
+    @return true if it would, false if it would be split up, disconnected or empty.
+*/
+bool BlockForestStruct::keepsConnected(unsigned int v) {
+    unsigned int pieces = localSplits(this, v, 256);
+    if (pieces == BLOCK_FOREST_NONE) {
+        pieces = std::min(splits(v), 2u);
+    }
+    m_asked = v;
+    m_askedSplits = pieces;
+    return m_components - 1 + pieces == 1;
+}
+
+/**
+    Takes a voxel out of the forest. The blocks it was in become dirty.
+
+    @param v The id of a live voxel.
+*/
+void BlockForestStruct::remove(unsigned int v) {
+    unsigned int pieces = m_asked == v ? m_askedSplits : localSplits(this, v, 256);
+    if (pieces == BLOCK_FOREST_NONE || pieces == 2) {
+        pieces = splits(v);
+    }
+    m_components += pieces;
+    m_components--;
+    for (int i = 0; i < m_blocksOf[v].size(); i++) {
+        unsigned int block = m_blocksOf[v][i];
+        if (!m_isDirty[block]) {
+            m_isDirty[block] = 1;
+            m_dirty.push_back(block);
+        }
+    }
+    m_alive[v] = 0;
+    m_size--;
+    m_asked = BLOCK_FOREST_NONE;
+}
@@ -127,6 +127,7 @@ CompFab::VoxelGridStruct::VoxelGridStruct(Vec3 lowerLeft, unsigned int dimX, uns
     m_dimZ = dimZ;
     m_size = dimX*dimY*dimZ;
     m_spacing = spacing;
+    m_ownsArray = true;
     
     //Allocate Memory
     m_insideArray = new unsigned int[m_size];
@@ -138,9 +139,24 @@ CompFab::VoxelGridStruct::VoxelGridStruct(Vec3 lowerLeft, unsigned int dimX, uns
     
 }
 
+CompFab::VoxelGridStruct::VoxelGridStruct(Vec3 lowerLeft, unsigned int dimX, unsigned int dimY, unsigned int dimZ, double spacing, unsigned int *insideArray)
+{
+    m_lowerLeft = lowerLeft;
+    m_dimX = dimX;
+    m_dimY = dimY;
+    m_dimZ = dimZ;
+    m_size = dimX*dimY*dimZ;
+    m_spacing = spacing;
+    m_ownsArray = false;
+    m_insideArray = insideArray;
+}
+
 CompFab::VoxelGridStruct::~VoxelGridStruct()
 {
-    delete[] m_insideArray;
+    if(m_ownsArray)
+    {
+        delete[] m_insideArray;
+    }
 }
 
 
@@ -0,0 +1,163 @@
+/**
+    CS591-W1 Final Project
+    ComponentLabels.cpp
+    Purpose: For labeling every connected region of the voxel grid at once.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#include <vector>
+#include <algorithm>
+#include "../include/ComponentLabels.h"
+
+/**
+    Finds the root of a cell, halving the path on the way.
+
+    @param parent The union-find parents.
+    @param cell A cell with a parent.
+    @return Its root.
+*/
+static inline uint32_t findRoot(uint32_t * parent, uint32_t cell) {
+    while (parent[cell] != cell) {
+        parent[cell] = parent[parent[cell]];
+        cell = parent[cell];
+    }
+    return cell;
+}
+
+/**
+    Joins the sets of two cells, keeping the smaller root, so every root is the first cell of its
+    set by linear index.
+
+    @param parent The union-find parents.
+    @param a A cell with a parent.
+    @param b Another cell with a parent.
+*/
+static inline void uniteCells(uint32_t * parent, uint32_t a, uint32_t b) {
+    a = findRoot(parent, a);
+    b = findRoot(parent, b);
+    if (a < b) {
+        parent[b] = a;
+    } else if (b < a) {
+        parent[a] = b;
+    }
+}
+
+/**
+    Labels the connected components of the cells whose parent was set to themselves, the others
+    holding COMPONENT_NONE.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param slabs The number of z slabs to split the grid into, as given to parallelRanges.
+    @param labels The labels, with m_parent seeded. Everything else is replaced.
+*/
+void labelSeeded(CompFab::VoxelGrid * voxel_list, unsigned int slabs, ComponentLabels * labels) {
+    const unsigned int dimX = voxel_list->m_dimX;
+    const unsigned int dimY = voxel_list->m_dimY;
+    const unsigned int dimZ = voxel_list->m_dimZ;
+    // Same strides as voxelIndex
+    const unsigned int row = dimY;
+    const unsigned int plane = dimX*dimY;
+    uint32_t *parent = labels->m_parent.data();
+    labels->m_component.resize(voxel_list->m_size);
+    uint32_t *component = labels->m_component.data();
+    slabs = std::max(1u, std::min(slabs, dimZ));
+
+    // First pass: link cells to their earlier neighbors within each slab. Every root written is
+    // inside the slab, so slabs never touch each other's cells
+    std::vector<unsigned int> starts(slabs + 1, dimZ);
+    parallelRanges(dimZ, slabs, [&](unsigned int slab, unsigned int zBegin, unsigned int zEnd) {
+        starts[slab] = zBegin;
+        for (unsigned int z = zBegin; z < zEnd; z++) {
+            for (unsigned int y = 0; y < dimY; y++) {
+                unsigned int i = z*plane + y*row;
+                for (unsigned int x = 0; x < dimX; x++, i++) {
+                    if (parent[i] == COMPONENT_NONE) {
+                        continue;
+                    }
+                    if (x > 0 && parent[i - 1] != COMPONENT_NONE) {
+                        uniteCells(parent, i, i - 1);
+                    }
+                    if (y > 0 && parent[i - row] != COMPONENT_NONE) {
+                        uniteCells(parent, i, i - row);
+                    }
+                    if (z > zBegin && parent[i - plane] != COMPONENT_NONE) {
+                        uniteCells(parent, i, i - plane);
+                    }
+                }
+            }
+        }
+    });
+
+    // Merge across the planes where slabs meet
+    for (unsigned int slab = 1; slab < slabs; slab++) {
+        unsigned int z = starts[slab];
+        for (unsigned int i = z*plane; i < (z + 1)*plane; i++) {
+            if (parent[i] != COMPONENT_NONE && parent[i - plane] != COMPONENT_NONE) {
+                uniteCells(parent, i, i - plane);
+            }
+        }
+    }
+
+    // Second pass, in three phases so no thread writes a cell another one reads: find each cell's
+    // root without compressing, number the roots, then give every cell its root's number
+    std::vector<unsigned int> roots(slabs + 1, 0);
+    parallelRanges(dimZ, slabs, [&](unsigned int slab, unsigned int zBegin, unsigned int zEnd) {
+        unsigned int found = 0;
+        for (unsigned int i = zBegin*plane; i < zEnd*plane; i++) {
+            uint32_t root = parent[i];
+            if (root != COMPONENT_NONE) {
+                while (parent[root] != root) {
+                    root = parent[root];
+                }
+                found += root == i;
+            }
+            component[i] = root;
+        }
+        roots[slab + 1] = found;
+    });
+    for (unsigned int slab = 0; slab < slabs; slab++) {
+        roots[slab + 1] += roots[slab];
+    }
+    parallelRanges(dimZ, slabs, [&](unsigned int slab, unsigned int zBegin, unsigned int zEnd) {
+        unsigned int next = roots[slab];
+        for (unsigned int i = zBegin*plane; i < zEnd*plane; i++) {
+            if (component[i] == i) {
+                parent[i] = next++;
+            }
+        }
+    });
+    const unsigned int count = roots[slabs];
+    std::vector<std::vector<unsigned int> > sizes(slabs);
+    parallelRanges(dimZ, slabs, [&](unsigned int slab, unsigned int zBegin, unsigned int zEnd) {
+        std::vector<unsigned int> & own = sizes[slab];
+        own.assign(count, 0);
+        for (unsigned int i = zBegin*plane; i < zEnd*plane; i++) {
+            if (component[i] != COMPONENT_NONE) {
+                component[i] = parent[component[i]];
+                own[component[i]]++;
+            }
+        }
+    });
+    labels->m_sizes.assign(count, 0);
+    for (unsigned int slab = 0; slab < slabs; slab++) {
+        for (unsigned int c = 0; c < count; c++) {
+            labels->m_sizes[c] += sizes[slab][c];
+        }
+    }
+}
+
+/**
+    Labels the connected components of the voxels that hold a label.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param label The label of the voxels to group.
+    @param labels The labels, replaced.
+    @param threads The number of threads to use, or 0 to pick from the grid size.
+*/
+void labelComponents(CompFab::VoxelGrid * voxel_list, unsigned int label, ComponentLabels * labels, unsigned int threads) {
+    const unsigned int *cells = voxel_list->m_insideArray;
+    labelComponentsIf(voxel_list, [=](unsigned int index) {
+        return cells[index] == label;
+    }, labels, threads);
+}
@@ -0,0 +1,260 @@
+/**
+    CS591-W1 Final Project
+    ExpansionFrontier.cpp
+    Purpose: For the candidate columns expandPiece grows a piece by, kept between steps.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#include <vector>
+#include <cmath>
+#include "../include/ExpansionFrontier.h"
+#include "../include/Direction.h"
+
+/**
+    Constructor for the ExpansionFrontierStruct class. Starts with nothing taken and no candidates.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param scores The accessibility scores the columns are weighted by.
+    @param normal The direction the piece is being removed; columns run along it.
+    @param limit The number of voxels the piece should reach.
+    @param exponent The power a column's score sum is raised to for its weight.
+*/
+ExpansionFrontierStruct::ExpansionFrontierStruct(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, Voxel normal, int limit, double exponent)
+    : m_taken(voxel_list->m_size), m_slots(voxel_list->m_size), m_trial(voxel_list) {
+    m_grid = voxel_list;
+    m_scores = scores;
+    m_normal = normal;
+    m_limit = limit;
+    m_exponent = exponent;
+    m_live = 0;
+    m_fitCount = 0;
+    m_round = 0;
+    m_rescored = 0;
+    m_slots->reserveValues();
+
+    Direction dir = toDirection(normal);
+    m_axis = dir == NO_DIRECTION ? -1 : directionAxis(dir);
+    m_sign = dir == NO_DIRECTION ? 1 : directionSign(dir);
+    m_prefix = g_scorePrefix;
+    if (m_prefix != NULL && (m_prefix->m_grid != voxel_list || m_prefix->m_scores != scores || dir == NO_DIRECTION)) {
+        m_prefix = NULL;
+    }
+    unsigned int lines = 1;
+    if (m_axis >= 0) {
+        int dim[3] = {(int)voxel_list->m_dimX, (int)voxel_list->m_dimY, (int)voxel_list->m_dimZ};
+        lines = dim[(m_axis + 1) % 3]*dim[(m_axis + 2) % 3];
+    }
+    m_lines.resize(lines);
+    m_lineRound.assign(lines, 0);
+    m_lineReach.assign(lines, 0);
+}
+
+/**
+    The line along the normal through a voxel, numbered as in RayIndex.
+
+    @param voxel The voxel.
+    @return Its line, or 0 if the normal isn't along an axis.
+*/
+unsigned int ExpansionFrontierStruct::line(const Voxel & voxel) const {
+    if (m_axis < 0) {
+        return 0;
+    }
+    int coord[3] = {voxel.x, voxel.y, voxel.z};
+    int dim[3] = {(int)m_grid->m_dimX, (int)m_grid->m_dimY, (int)m_grid->m_dimZ};
+    return coord[(m_axis + 2) % 3]*dim[(m_axis + 1) % 3] + coord[(m_axis + 1) % 3];
+}
+
+/**
+    How far along the normal a voxel lies, so that a column holds the cells of its line that are
+    at least as far as its candidate.
+
+    @param voxel The voxel.
+    @return Its coordinate along the normal's axis, negated if the normal points down it, or 0 if
+            the normal isn't along an axis.
+*/
+int ExpansionFrontierStruct::along(const Voxel & voxel) const {
+    if (m_axis < 0) {
+        return 0;
+    }
+    int coord = m_axis == 0 ? voxel.x : m_axis == 1 ? voxel.y : voxel.z;
+    return m_sign*coord;
+}
+
+/**
+    Takes a cell, so it is in no column and never becomes a candidate. A candidate taken this way
+    is retired.
+
+    @param voxel The cell.
+*/
+void ExpansionFrontierStruct::take(const Voxel & voxel) {
+    unsigned int index = voxelIndex(m_grid, voxel);
+    m_taken->mark(index);
+    m_changed.push_back(voxel);
+    if (!m_slots->marked(index)) {
+        return;
+    }
+    unsigned int slot = m_slots->value(index);
+    m_slots->unmark(index);
+    m_all.set(slot, 0);
+    m_fitting.set(slot, 0);
+    if (m_fits[slot]) {
+        m_fits[slot] = false;
+        m_fitCount--;
+    }
+    m_live--;
+}
+
+/**
+    Finds the new candidates around the latest cells of a piece: their unassigned neighbors that
+    are neither taken nor candidates already, in the order a scan of the whole piece would meet
+    them.
+
+    @param piece The piece, whose cells must all be taken.
+    @param from The first cell of the piece that is new since the last call.
+*/
+void ExpansionFrontierStruct::grow(const Piece & piece, int from) {
+    for (int i = from; i < piece.size(); i++) {
+        Neighbors neighbors = getNeighbors(piece[i], m_grid, 1);
+        for (int j = 0; j < neighbors.size(); j++) {
+            unsigned int index = neighbors.index(j);
+            if (m_taken->marked(index) || m_slots->marked(index)) {
+                continue;
+            }
+            unsigned int slot = m_all.add(0);
+            m_fitting.add(0);
+            m_slots->mark(index);
+            m_slots->value(index) = slot;
+            m_voxels.push_back(neighbors[j]);
+            m_columns.push_back(0);
+            m_fits.push_back(false);
+            m_lines[line(neighbors[j])].push_back(slot);
+            m_changed.push_back(neighbors[j]);
+            m_live++;
+        }
+    }
+}
+
+/**
+    Brings every candidate's weight up to date: rescores the ones whose columns reach a cell taken
+    or found since the last call, then drops the ones whose columns no longer fit.
+
+    @param count The number of voxels in the piece.
+*/
+void ExpansionFrontierStruct::rescore(int count) {
+    m_round++;
+    // Lines with a change, each with the farthest along the normal its changes go
+    m_touched.clear();
+    for (int i = 0; i < m_changed.size(); i++) {
+        unsigned int l = line(m_changed[i]);
+        int reach = along(m_changed[i]);
+        if (m_lineRound[l] != m_round) {
+            m_lineRound[l] = m_round;
+            m_lineReach[l] = reach;
+            m_touched.push_back(l);
+        } else if (reach > m_lineReach[l]) {
+            m_lineReach[l] = reach;
+        }
+    }
+    for (int i = 0; i < m_touched.size(); i++) {
+        unsigned int l = m_touched[i];
+        std::vector<unsigned int> & slots = m_lines[l];
+        unsigned int kept = 0;
+        for (unsigned int s = 0; s < slots.size(); s++) {
+            unsigned int slot = slots[s];
+            if (!m_slots->marked(voxelIndex(m_grid, m_voxels[slot]))) {
+                continue;
+            }
+            slots[kept++] = slot;
+            if (along(m_voxels[slot]) <= m_lineReach[l]) {
+                score(slot, count);
+            }
+        }
+        slots.resize(kept);
+    }
+    m_changed.clear();
+
+    while (!m_heap.empty() && m_heap.top().first > m_limit - count) {
+        unsigned int slot = m_heap.top().second;
+        int column = m_heap.top().first;
+        m_heap.pop();
+        if (m_fits[slot] && m_columns[slot] == column) {
+            m_fits[slot] = false;
+            m_fitCount--;
+            m_fitting.set(slot, 0);
+        }
+    }
+}
+
+/**
+    Scores one candidate: sums the scores of the cells its column would add, after restoring the
+    column's connectivity if it falls apart.
+
+    @param slot The candidate.
+    @param count The number of voxels in the piece.
+*/
+void ExpansionFrontierStruct::score(unsigned int slot, int count) {
+    m_rescored++;
+    m_piece.clear();
+    m_column.clear();
+    collectAlongRay(m_grid, m_voxels[slot], m_normal, 1, &m_column);
+    // Whether the piece would take the whole column, as it stands
+    bool wholeColumn = true;
+    for (int j = 0; j < m_column.size(); j++) {
+        unsigned int index = voxelIndex(m_grid, m_column[j]);
+        if (m_taken->marked(index) || (m_slots->marked(index) && m_slots->value(index) > slot)) {
+            wholeColumn = false;
+        } else {
+            m_piece.insert(m_column[j]);
+        }
+    }
+    m_columns[slot] = m_piece.size();
+    // ensurePieceConnectivity leaves a connected piece as it is
+    for (int j = 0; j < m_piece.size(); j++) {
+        m_trial.include(m_piece[j]);
+    }
+    if (m_trial.components() > 1) {
+        m_piece = ensurePieceConnectivity(m_grid, m_piece, m_normal);
+        wholeColumn = false;
+    }
+    m_trial.rollback();
+    double sum = 0;
+    if (wholeColumn && m_prefix != NULL) {
+        sum = m_prefix->runSum(m_voxels[slot], toDirection(m_normal));
+    } else {
+        for (int j = 0; j < m_piece.size(); j++) {
+            sum += m_scores->score(m_piece[j].x, m_piece[j].y, m_piece[j].z);
+        }
+    }
+    // A zero sum gives an infinite weight for a negative exponent, which the samplers cap
+    double weight = std::pow(sum, m_exponent);
+    m_all.set(slot, weight);
+
+    bool fits = count + m_columns[slot] <= m_limit;
+    if (fits != m_fits[slot]) {
+        m_fits[slot] = fits;
+        if (fits) {
+            m_fitCount++;
+        } else {
+            m_fitCount--;
+        }
+    }
+    m_fitting.set(slot, fits ? weight : 0);
+    if (fits) {
+        m_heap.push(std::make_pair(m_columns[slot], slot));
+    }
+}
+
+/**
+    Draws a candidate with probability proportional to its weight, among the ones that fit, or
+    among all of them if none does.
+
+    @param random A uniform random number in [0, 1].
+    @return The slot of the candidate drawn, or -1 if there are none.
+*/
+int ExpansionFrontierStruct::choose(double random) const {
+    if (m_fitCount > 0) {
+        return m_fitting.draw(random);
+    }
+    return m_all.draw(random);
+}
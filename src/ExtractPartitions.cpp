@@ -10,14 +10,34 @@
 #include <vector>
 #include <string>
 #include <cmath>
+#include <cstdlib>
 #include <algorithm>
-#include <list>
 #include <limits>
+#include <unordered_map>
 #include "../include/ExtractPartitions.h"
 #include "../include/CompFab.h"
+#include "../include/RayIndex.h"
+#include "../include/Direction.h"
+#include "../include/ScratchGrid.h"
+#include "../include/VoxelSearch.h"
+#include "../include/BitVolume.h"
+#include "../include/RemainderOracle.h"
+#include "../include/BlockForest.h"
+#include "../include/GridTransaction.h"
+#include "../include/AccessibilityEngine.h"
+#include "../include/AccessibilityScorer.h"
+#include "../include/ScorePrefix.h"
+#include "../include/ExpansionFrontier.h"
 
 bool debug = false;
 
+// Index of the unassigned (label 1) voxels, kept current by setVoxelLabel
+RayIndex * g_rayIndex = NULL;
+// Connectivity of the unassigned voxels, kept current by setVoxelLabel
+RemainderOracle * g_remainderOracle = NULL;
+// Running sums of the unassigned voxels' scores, kept current by setVoxelLabel
+ScorePrefix * g_scorePrefix = NULL;
+
 /**
     Blank constructor for the Voxel class. Generates a voxel at the origin.
 */
@@ -72,7 +92,7 @@ VoxelSort::VoxelSort(Voxel vox, double totalScore) {
 
     @return A human readable string of a voxel as (x, y, z).
 */
-std::string Voxel::toString() {
+std::string Voxel::toString() const {
     std::string vox("(" + std::to_string(x) + "," + std::to_string(y) + "," + std::to_string(z) + ")");
     return vox;
 }
@@ -100,6 +120,7 @@ AccessibilityStruct::AccessibilityStruct(CompFab::Vec3 lowerLeft, unsigned int d
     m_dimY = dimY;
     m_dimZ = dimZ;
     m_size = dimX*dimY*dimZ;
+    m_ownsArray = true;
 
     m_scoreArray = new double[m_size];
 
@@ -110,12 +131,121 @@ AccessibilityStruct::AccessibilityStruct(CompFab::Vec3 lowerLeft, unsigned int d
 
 }
 
+/**
+    Constructor for the AccessibilityStruct class over an existing score array, e.g. one mapped from a snapshot.
+    The array is not owned and is not freed by the destructor.
+    
+    @param lowerLeft A vector representing the lower left voxel in the grid. Usually is (0,0,0).
+    @param dimX The dimension of x.
+    @param dimY The dimension of y.
+    @param dimZ The dimension of z.
+    @param scoreArray The dimX*dimY*dimZ scores to wrap.
+*/
+AccessibilityStruct::AccessibilityStruct(CompFab::Vec3 lowerLeft, unsigned int dimX, unsigned int dimY, unsigned int dimZ, double *scoreArray) {
+    m_lowerLeft = lowerLeft;
+    m_dimX = dimX;
+    m_dimY = dimY;
+    m_dimZ = dimZ;
+    m_size = dimX*dimY*dimZ;
+    m_ownsArray = false;
+    m_scoreArray = scoreArray;
+}
+
 /**
     Destructor for the AccessibilityStruct class.
 */
 AccessibilityStruct::~AccessibilityStruct()
 {
-    delete[] m_scoreArray;
+    if (m_ownsArray) {
+        delete[] m_scoreArray;
+    }
+}
+
+/**
+    Constructor for the PieceStruct class from a list of voxels. Repeated voxels are kept once.
+
+    @param voxels The voxels of the piece.
+*/
+PieceStruct::PieceStruct(const std::vector<Voxel> & voxels) {
+    m_voxels.reserve(voxels.size());
+    for (int i = 0; i < voxels.size(); i++) {
+        insert(voxels[i]);
+    }
+}
+
+/**
+    Checks whether a voxel belongs to the piece.
+
+    @param voxel The voxel to check.
+    @return true if it does, false otherwise.
+*/
+bool PieceStruct::contains(const Voxel & voxel) const {
+    return m_position.count(key(voxel)) != 0;
+}
+
+/**
+    Adds a voxel to the end of the piece if it isn't already in it.
+
+    @param voxel The voxel to add.
+    @return true if the voxel was added, false if it was already in the piece.
+*/
+bool PieceStruct::insert(const Voxel & voxel) {
+    if (!m_position.insert(std::make_pair(key(voxel), (unsigned int)m_voxels.size())).second) {
+        return false;
+    }
+    m_voxels.push_back(voxel);
+    return true;
+}
+
+/**
+    Removes a voxel from the piece. The last voxel takes its place.
+
+    @param voxel The voxel to remove.
+    @return true if the voxel was removed, false if it wasn't in the piece.
+*/
+bool PieceStruct::erase(const Voxel & voxel) {
+    std::unordered_map<uint64_t, unsigned int>::iterator it = m_position.find(key(voxel));
+    if (it == m_position.end()) {
+        return false;
+    }
+    unsigned int position = it->second;
+    m_position.erase(it);
+    if (position != m_voxels.size() - 1) {
+        m_voxels[position] = m_voxels.back();
+        m_position[key(m_voxels[position])] = position;
+    }
+    m_voxels.pop_back();
+    return true;
+}
+
+/**
+    Adds every voxel of another piece that isn't already in this one, in the other piece's order.
+
+    @param other The piece to merge in.
+*/
+void PieceStruct::unite(const PieceStruct & other) {
+    for (int i = 0; i < other.size(); i++) {
+        insert(other[i]);
+    }
+}
+
+/**
+    Removes every voxel of another piece from this one.
+
+    @param other The piece whose voxels are removed.
+*/
+void PieceStruct::subtract(const PieceStruct & other) {
+    for (int i = 0; i < other.size(); i++) {
+        erase(other[i]);
+    }
+}
+
+/**
+    Removes every voxel from the piece.
+*/
+void PieceStruct::clear() {
+    m_voxels.clear();
+    m_position.clear();
 }
 
 /**
@@ -129,6 +259,26 @@ void printList(std::vector<Voxel> list) {
     }
 }
 
+/**
+    Prints a list of neighbors.
+
+    @param list The neighbors to be printed.
+*/
+void printList(Neighbors list) {
+    for (int i = 0; i < list.size(); i++) {
+        std::cout << "\t\t" << list[i].toString() << std::endl;
+    }
+}
+
+/**
+    Prints the voxels of a piece.
+
+    @param list The piece to be printed.
+*/
+void printList(const Piece & list) {
+    printList(list.voxels());
+}
+
 /**
     Finds seeds for the key piece to start from.
 
@@ -142,21 +292,13 @@ std::vector<Voxel> findSeeds( CompFab::VoxelGrid * voxel_list ) {
     int ny = voxel_list->m_dimY;
     int nz = voxel_list->m_dimZ;
     
-    int above = 0;
     int one_side_adjacent;
     for (int i = 0; i < nx; i++) {
         for (int j = 0; j < ny; j++) {
             for (int k = 0; k < nz; k++) {
                 if (voxel_list->isInside(i,j,k) == 1) {
                     // First check if any voxels above
-                    for (int z = k+1 ; z < nz; z++) {
-                        if (voxel_list->isInside(i,j,z) == 1) {
-                            above = 1;
-                            break;
-                        }
-                    }
-                    if (above) {
-                        above = 0;
+                    if (countAlongRay(voxel_list, Voxel(i, j, k+1), Voxel(0, 0, 1), 1) > 0) {
                         continue;
                     }
                     //Now, check that only two other faces are open and (except bottom)
@@ -197,45 +339,251 @@ std::vector<Voxel> findSeeds( CompFab::VoxelGrid * voxel_list ) {
 
     @param voxel The voxel from which to find neighbors.
     @param voxel_list A VoxelGrid representing the current state of the puzzle.
-    @return The neighbors of the voxel.
+    @param pieceId The id neighbors must have to be included.
+    @return The neighbors of the voxel, along with their linear indices.
 */
-std::vector<Voxel> getNeighbors(Voxel voxel, CompFab::VoxelGrid * voxel_list, int pieceId) {
-    std::vector<Voxel> neighbors;
-    int nx = voxel_list->m_dimX;
-    int ny = voxel_list->m_dimY;
-    int nz = voxel_list->m_dimZ;
-    
-    if ( voxel.x != 0 ) {
-        if (voxel_list->isInside(voxel.x-1,voxel.y,voxel.z) == pieceId) {
-            neighbors.push_back(Voxel(voxel.x-1,voxel.y,voxel.z));
-        }
-    }   
-    if ( voxel.x != nx-1 ) {
-        if (voxel_list->isInside(voxel.x+1,voxel.y,voxel.z) == pieceId) {
-            neighbors.push_back(Voxel(voxel.x+1,voxel.y,voxel.z));
-        }
-    }   
-    if (voxel.y != 0) {
-        if (voxel_list->isInside(voxel.x,voxel.y-1,voxel.z) == pieceId) {
-            neighbors.push_back(Voxel(voxel.x,voxel.y-1,voxel.z));
-        }
-    }   
-    if (voxel.y != ny-1) {
-        if (voxel_list->isInside(voxel.x,voxel.y+1,voxel.z) == pieceId) {
-            neighbors.push_back(Voxel(voxel.x,voxel.y+1,voxel.z));
+Neighbors getNeighbors(Voxel voxel, CompFab::VoxelGrid * voxel_list, int pieceId) {
+    Neighbors neighbors;
+    forEachNeighbor(voxel_list, voxel, pieceId, [&neighbors](const Voxel & neighbor, unsigned int index) {
+        neighbors.push_back(neighbor, index);
+    });
+    return neighbors;
+}
+
+/**
+    Builds the ray index over the unassigned voxels of a grid. From then on every label change to
+    the grid must go through setVoxelLabel.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+*/
+void buildRayIndex( CompFab::VoxelGrid * voxel_list ) {
+    delete g_rayIndex;
+    g_rayIndex = new RayIndex(voxel_list, 1);
+}
+
+/**
+    Builds the connectivity oracle over the unassigned voxels of a grid, which verifyPiece then
+    uses. Like the ray index, it needs every later label change to go through setVoxelLabel.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+*/
+void buildRemainderOracle( CompFab::VoxelGrid * voxel_list ) {
+    delete g_remainderOracle;
+    g_remainderOracle = new RemainderOracle(voxel_list);
+}
+
+/**
+    Builds the running score sums over the unassigned voxels that expandPiece reads, unless the
+    current ones already cover these scores. Like the ray index, they need every later label
+    change to go through setVoxelLabel.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param scores The scores to sum. Must keep their m_scoreArray while the sums are in use.
+*/
+void buildScorePrefix( CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores ) {
+    if (g_scorePrefix != NULL && g_scorePrefix->m_grid == voxel_list && g_scorePrefix->m_scores == scores) {
+        return;
+    }
+    delete g_scorePrefix;
+    g_scorePrefix = new ScorePrefix(voxel_list, scores, 1);
+}
+
+/**
+    Sets the label of a voxel, keeping the ray index and remainder oracle up to date, and telling the
+    accessibility engine and score sums what went stale.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param voxel The voxel being relabelled.
+    @param label The new label.
+*/
+void setVoxelLabel( CompFab::VoxelGrid * voxel_list, Voxel voxel, unsigned int label) {
+    unsigned int & current = voxel_list->isInside(voxel.x, voxel.y, voxel.z);
+    if (g_rayIndex != NULL && g_rayIndex->m_grid == voxel_list && (current == g_rayIndex->m_label) != (label == g_rayIndex->m_label)) {
+        g_rayIndex->update(voxel, label == g_rayIndex->m_label);
+    }
+    if (g_remainderOracle != NULL && g_remainderOracle->m_grid == voxel_list && (current == 1) != (label == 1)) {
+        g_remainderOracle->update(voxel, label == 1);
+    }
+    if (g_accessibility != NULL && g_accessibility->m_grid == voxel_list && ((int)current == g_accessibility->m_label) != ((int)label == g_accessibility->m_label)) {
+        g_accessibility->touch(voxel);
+    }
+    if (g_scorePrefix != NULL && g_scorePrefix->m_grid == voxel_list && (current == g_scorePrefix->m_label) != (label == g_scorePrefix->m_label)) {
+        g_scorePrefix->touch(voxel);
+    }
+    current = label;
+}
+
+/**
+    Checks if a voxel is inside the grid.
+*/
+static inline bool inGrid( CompFab::VoxelGrid * voxel_list, const Voxel & voxel) {
+    return voxel.x > -1 && voxel.x < (int)voxel_list->m_dimX && voxel.y > -1 && voxel.y < (int)voxel_list->m_dimY && voxel.z > -1 && voxel.z < (int)voxel_list->m_dimZ;
+}
+
+/**
+    Finds how far along a direction a voxel lies, i.e. the dot product of the two.
+*/
+static inline int alongRay( const Voxel & voxel, const Voxel & dir) {
+    return voxel.x*dir.x + voxel.y*dir.y + voxel.z*dir.z;
+}
+
+/**
+    Identifies the grid line through a voxel parallel to an axis direction.
+*/
+static inline unsigned int lineKey( CompFab::VoxelGrid * voxel_list, const Voxel & voxel, const Voxel & dir) {
+    return voxelIndex(voxel_list, Voxel(dir.x ? 0 : voxel.x, dir.y ? 0 : voxel.y, dir.z ? 0 : voxel.z));
+}
+
+/**
+    Returns the ray index if it can answer queries for this grid and label, NULL otherwise.
+*/
+static inline RayIndex * rayIndexFor( CompFab::VoxelGrid * voxel_list, int label) {
+    if (g_rayIndex != NULL && g_rayIndex->m_grid == voxel_list && g_rayIndex->m_label == (unsigned int)label) {
+        return g_rayIndex;
+    }
+    return NULL;
+}
+
+/*
+    Ray marches for labels the ray index doesn't cover, specialized per direction so each one is a
+    fixed-stride walk over the label array.
+*/
+template <Direction D>
+struct NearestOnRay {
+    static Voxel run(CompFab::VoxelGrid * voxel_list, Voxel from, unsigned int label) {
+        const int stride = directionStride<D>(voxel_list);
+        const int steps = stepsToEdge<D>(voxel_list, from);
+        const unsigned int *cell = voxel_list->m_insideArray + voxelIndex(voxel_list, from);
+        for (int t = 0; t <= steps; t++, cell += stride) {
+            if (*cell == label) {
+                return stepVoxel<D>(from, t);
+            }
         }
-    }   
-    if (voxel.z != 0) {
-        if (voxel_list->isInside(voxel.x,voxel.y,voxel.z-1) == pieceId) {
-            neighbors.push_back(Voxel(voxel.x,voxel.y,voxel.z-1));
+        return Voxel(-1, -1, -1);
+    }
+};
+
+template <Direction D>
+struct FarthestOnRay {
+    static Voxel run(CompFab::VoxelGrid * voxel_list, Voxel from, unsigned int label) {
+        const int stride = directionStride<D>(voxel_list);
+        const int steps = stepsToEdge<D>(voxel_list, from);
+        const unsigned int *cell = voxel_list->m_insideArray + voxelIndex(voxel_list, from) + steps*stride;
+        for (int t = steps; t >= 0; t--, cell -= stride) {
+            if (*cell == label) {
+                return stepVoxel<D>(from, t);
+            }
         }
-    }   
-    if (voxel.z != nz-1) {
-        if (voxel_list->isInside(voxel.x,voxel.y,voxel.z+1) == pieceId) {
-            neighbors.push_back(Voxel(voxel.x,voxel.y,voxel.z+1));
+        return Voxel(-1, -1, -1);
+    }
+};
+
+template <Direction D>
+struct CountOnRay {
+    static int run(CompFab::VoxelGrid * voxel_list, Voxel from, unsigned int label) {
+        const int stride = directionStride<D>(voxel_list);
+        const int steps = stepsToEdge<D>(voxel_list, from);
+        const unsigned int *cell = voxel_list->m_insideArray + voxelIndex(voxel_list, from);
+        int count = 0;
+        for (int t = 0; t <= steps; t++, cell += stride) {
+            count += (*cell == label);
         }
+        return count;
     }
-    return neighbors;
+};
+
+/**
+    Finds the closest voxel with a label on the ray starting at from (inclusive) and stepping by dir.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param from The first voxel of the ray.
+    @param dir A unit step along one axis. Any other step gives an empty ray.
+    @param label The label being searched for.
+    @return The voxel, or (-1, -1, -1) if there is none.
+*/
+Voxel nearestAlongRay( CompFab::VoxelGrid * voxel_list, Voxel from, Voxel dir, int label) {
+    Direction d = toDirection(dir);
+    if (d == NO_DIRECTION || !inGrid(voxel_list, from)) {
+        return Voxel(-1, -1, -1);
+    }
+    RayIndex * index = rayIndexFor(voxel_list, label);
+    if (index != NULL) {
+        return index->nearest(from, d);
+    }
+    return dispatchDirection<NearestOnRay>(d, voxel_list, from, (unsigned int)label);
+}
+
+/**
+    Finds the furthest voxel with a label on the ray starting at from (inclusive) and stepping by dir.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param from The first voxel of the ray.
+    @param dir A unit step along one axis. Any other step gives an empty ray.
+    @param label The label being searched for.
+    @return The voxel, or (-1, -1, -1) if there is none.
+*/
+Voxel farthestAlongRay( CompFab::VoxelGrid * voxel_list, Voxel from, Voxel dir, int label) {
+    Direction d = toDirection(dir);
+    if (d == NO_DIRECTION || !inGrid(voxel_list, from)) {
+        return Voxel(-1, -1, -1);
+    }
+    RayIndex * index = rayIndexFor(voxel_list, label);
+    if (index != NULL) {
+        return index->farthest(from, d);
+    }
+    return dispatchDirection<FarthestOnRay>(d, voxel_list, from, (unsigned int)label);
+}
+
+/**
+    Counts the voxels with a label on the ray starting at from (inclusive) and stepping by dir.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param from The first voxel of the ray.
+    @param dir A unit step along one axis. Any other step gives an empty ray.
+    @param label The label being counted.
+    @return The number of voxels with that label on the ray.
+*/
+int countAlongRay( CompFab::VoxelGrid * voxel_list, Voxel from, Voxel dir, int label) {
+    Direction d = toDirection(dir);
+    if (d == NO_DIRECTION || !inGrid(voxel_list, from)) {
+        return 0;
+    }
+    RayIndex * index = rayIndexFor(voxel_list, label);
+    if (index != NULL) {
+        return index->count(from, d);
+    }
+    return dispatchDirection<CountOnRay>(d, voxel_list, from, (unsigned int)label);
+}
+
+/**
+    Appends every voxel with a label on the ray starting at from (inclusive) and stepping by dir, in ray order.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param from The first voxel of the ray.
+    @param dir A unit step along one axis. Any other step gives an empty ray.
+    @param label The label being collected.
+    @param out The list the voxels are appended to.
+*/
+void collectAlongRay( CompFab::VoxelGrid * voxel_list, Voxel from, Voxel dir, int label, std::vector<Voxel> * out) {
+    for (Voxel end = nearestAlongRay(voxel_list, from, dir, label); end.x != -1; end = nearestAlongRay(voxel_list, end + dir, dir, label)) {
+        out->push_back(end);
+    }
+}
+
+/**
+    Loads the unassigned voxels of a grid into a bit volume, copying the ray index's x lines when
+    it is current, since they have the same layout.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param volume A volume the size of voxel_list.
+*/
+static void loadUnassigned( CompFab::VoxelGrid * voxel_list, BitVolume * volume) {
+    RayIndex * index = rayIndexFor(voxel_list, 1);
+    if (index != NULL) {
+        volume->m_bits = index->m_lines[0];
+        return;
+    }
+    loadLabel(voxel_list, 1, volume);
 }
 
 /**
@@ -245,42 +593,14 @@ std::vector<Voxel> getNeighbors(Voxel voxel, CompFab::VoxelGrid * voxel_list, in
     @param alpha A double used as a param for how to generate the scores.
     @param recurse How many layers of recursion to perform in score generation.
     @param pieceId The id of the piece we are scoring. Is usually 1.
-    @return The accessiblity scores of each voxel in the form of an AccessibilityGrid.
+    @return The accessiblity scores of each voxel in the form of an AccessibilityGrid, which the
+            caller deletes.
 */
 AccessibilityGrid * accessibilityScores( CompFab::VoxelGrid * voxel_list, double alpha, unsigned int recurse, int pieceId) {
-    int nx = voxel_list->m_dimX;
-    int ny = voxel_list->m_dimY;
-    int nz = voxel_list->m_dimZ;
+    static thread_local AccessibilityScorer scorer;
     CompFab::Vec3 start = CompFab::Vec3(0.0, 0.0, 0.0);
-    AccessibilityGrid * scores = new AccessibilityGrid(start, nx, ny, nz);
-    if (recurse == 0) {
-        for (int i = 0; i < nx; i++) {
-            for (int j = 0; j < ny; j++) {
-                for (int k = 0; k < nz; k++) {
-                    scores->score(i, j, k) = getNeighbors(Voxel(i, j, k), voxel_list, pieceId).size();         
-                }
-            }
-        }
-    } else {
-        double current_score;
-        double multiplier = pow(alpha, recurse);
-        std::vector<Voxel> neighbors;
-        AccessibilityGrid * old_scores = accessibilityScores( voxel_list, alpha, recurse-1, pieceId);
-        for (int i = 0; i < nx; i++) {
-            for (int j = 0; j < ny; j++) {
-                for (int k = 0; k < nz; k++) {
-                    neighbors = getNeighbors(Voxel(i, j, k), voxel_list, pieceId);
-                    current_score = 0;
-                    for (int n = 0; n < neighbors.size(); n++) {
-                        current_score += old_scores->score(neighbors[n].x, neighbors[n].y, neighbors[n].z);
-                    }
-                    current_score *= multiplier;
-                    current_score += old_scores->score(i,j,k);
-                    scores->score(i,j,k) = current_score;
-                }
-            }
-        }
-    }
+    AccessibilityGrid * scores = new AccessibilityGrid(start, voxel_list->m_dimX, voxel_list->m_dimY, voxel_list->m_dimZ);
+    scorer.score(voxel_list, alpha, recurse, pieceId, scores->m_scoreArray);
     return scores;
 }
 
@@ -293,38 +613,14 @@ AccessibilityGrid * accessibilityScores( CompFab::VoxelGrid * voxel_list, double
     @return The direction of the exposed face of the piece that isn't bad_normal.
 */
 Voxel findNormal( CompFab::VoxelGrid * voxel_list, Voxel voxel, Voxel bad_normal) {
-    int nx = voxel_list->m_dimX;
-    int ny = voxel_list->m_dimY;
-    int nz = voxel_list->m_dimZ;
-    
-    if ( bad_normal.x != -1 ) {
-        if (voxel.x == 0 || voxel_list->isInside(voxel.x-1,voxel.y,voxel.z) != 1) {
-            return Voxel(-1, 0, 0);
-        }
-    }
-    if ( bad_normal.x != 1 ) {
-        if (voxel.x == nx-1 || voxel_list->isInside(voxel.x+1,voxel.y,voxel.z) != 1) {
-            return Voxel(1, 0, 0);
-        }
-    }
-    if ( bad_normal.y != -1) {
-        if (voxel.y == 0 || voxel_list->isInside(voxel.x,voxel.y-1,voxel.z) != 1) {
-            return Voxel(0, -1, 0);
+    for (int d = NEG_X; d < NO_DIRECTION; d++) {
+        Voxel dir = directionVoxel((Direction)d);
+        if (alongRay(bad_normal, dir) == 1) {
+            continue;
         }
-    }
-    if ( bad_normal.y != 1) {
-        if (voxel.y == ny-1 || voxel_list->isInside(voxel.x,voxel.y+1,voxel.z) != 1) {
-            return Voxel(0, 1, 0);
-        }
-    }
-    if ( bad_normal.z != -1) {
-        if (voxel.z == 0 || voxel_list->isInside(voxel.x,voxel.y,voxel.z-1) != 1) {
-            return Voxel(0, 0, -1); 
-        }
-    }
-    if ( bad_normal.z != 1) {
-        if (voxel.z == nz-1 || voxel_list->isInside(voxel.x,voxel.y,voxel.z+1) != 1) {
-            return Voxel(0, 0, 1);
+        Voxel next = voxel + dir;
+        if (!inGrid(voxel_list, next) || voxel_list->isInside(next.x, next.y, next.z) != 1) {
+            return dir;
         }
     }
     std::cout << "error" << std::endl;
@@ -361,38 +657,32 @@ std::vector<VoxelPair> bfs(CompFab::VoxelGrid * voxel_list, AccessibilityGrid *
     Voxel normal = findNormal(voxel_list, seed, bad_normal);
 
     // Mark all the vertices as not visited
-    bool *visited = new bool[size];
-    for(unsigned int i=0; i<size; ++i) {
-        visited[i] = false;
-    }
+    ScratchLease visited(size);
     
     // Create a queue for BFS
-    std::list<Voxel> queue;
-    std::vector<Voxel> neighbors;
+    IndexQueue & queue = visited->m_queue;
     Voxel blockee;
     Voxel blocker;
     //Mark the current node as visited and enqueue it
-    visited[seed.z*(nx*ny) + seed.y*ny + seed.x] = true;
-    queue.push_back(seed);
+    visited->mark(voxelIndex(voxel_list, seed));
+    queue.push(voxelIndex(voxel_list, seed));
     
     int count = 0;
     while (!queue.empty() && potentials.size() < nb_one) {
         count++;
-        blockee = queue.front();
+        blockee = voxelAt(voxel_list, queue.front());
         blocker = blockee + normal;
         if (blocker.x < 0 || blocker.x >= nx || blocker.y < 0 || blocker.y >= ny || blocker.z < 0 || blocker.z >= nz) {
             ;
         } else if (voxel_list->isInside(blocker.x, blocker.y, blocker.z) == 1 && blocker != seed) {
             potentials.push_back(VoxelPair(blocker, scores->score(blocker.x, blocker.y, blocker.z), blockee, scores->score(blockee.x, blockee.y, blockee.z)));
         }
-        queue.pop_front();
-        neighbors = getNeighbors(blockee, voxel_list, 1);
-        for (int i = 0; i < neighbors.size(); i++) {
-            if ( !visited[ neighbors[i].z*(nx*ny) + neighbors[i].y*ny + neighbors[i].x ] ) {
-                visited[ neighbors[i].z*(nx*ny) + neighbors[i].y*ny + neighbors[i].x ] = true;
-                queue.push_back(neighbors[i]);
+        queue.pop();
+        forEachNeighbor(voxel_list, blockee, 1, [&](const Voxel & next, unsigned int index) {
+            if (visited->testAndMark(index)) {
+                queue.push(index);
             }
-        }
+        });
     }
     if (debug) {
         std::cout << "in bfs, went through: " << count << std::endl;
@@ -403,10 +693,58 @@ std::vector<VoxelPair> bfs(CompFab::VoxelGrid * voxel_list, AccessibilityGrid *
     for (int i = 0; i< potentials.size() && i < nb_two; i++) {
         accessible.push_back(potentials[i]);
     }
-    delete[] visited;
     return accessible;
 }
 
+/**
+    Keeps a search out of the unassigned voxels on and behind each anchor, looking against the
+    direction of removal.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param search The search to restrict.
+    @param anchors A list of forbidden voxels to ensure interlocking.
+    @param direction The direction which the piece is being removed.
+*/
+static void forbidAnchorColumns(CompFab::VoxelGrid * voxel_list, VoxelSearch * search, const std::vector<Voxel> & anchors, Voxel direction) {
+    Voxel neg_dir(direction.x*-1, direction.y*-1, direction.z*-1);
+    std::vector<Voxel> column;
+    // ok so this is an issue, adding everything below anchors instead of general
+    for (int i = 0; i < anchors.size(); i++) {
+        collectAlongRay(voxel_list, anchors[i], neg_dir, 1, &column);
+    }
+    if (debug) {
+        for (int i = 0; i < column.size(); i++) {
+            std::cout << "\tsetting " << column[i].toString() << " to visited" <<std::endl;
+        }
+    }
+    search->forbid(column);
+}
+
+/**
+    Adds the unassigned voxels in the direction of removal from each voxel of a path, so nothing
+    is left blocking it.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param path The path.
+    @param direction The direction which the piece is being removed.
+    @return The path, each voxel followed by the voxels it sweeps.
+*/
+static std::vector<Voxel> sweepPath(CompFab::VoxelGrid * voxel_list, const std::vector<Voxel> & path, Voxel direction) {
+    std::vector<Voxel> final_path;
+    // add things in the direction
+    for (int i = 0; i < path.size(); i++) {
+        final_path.push_back(path[i]);
+        collectAlongRay(voxel_list, path[i] + direction, direction, 1, &final_path);
+    }
+    if (debug) {
+        std::cout << "final path:" << std::endl;
+        printList(final_path);
+    }
+    // Now... make sure that piece is connected after adding things. Otherwise need more path finding.
+    //final_path = ensurePieceConnectivity(voxel_list, final_path, direction);
+    return final_path;
+}
+
 /**
     Uses breadth first search to find the shortest path from the seed to the blockee voxel specficied.
 
@@ -424,101 +762,62 @@ std::vector<Voxel> shortestPath(CompFab::VoxelGrid * voxel_list, Voxel seed, Vox
         std::cout << "the goal is" << goal.toString() << std::endl;
         std::cout << "\tdirection of removal is " << direction.toString() << std::endl;
     }
-    int nx = voxel_list->m_dimX;
-    int ny = voxel_list->m_dimY;
-    int nz = voxel_list->m_dimZ;
-    int size = nx*ny*nz;
-    
-    std::vector<Voxel> path;
-    // Mark all the vertices as not visited
-    bool *visited = new bool[size];
-    for(unsigned int i=0; i<size; ++i) {
-        visited[i] = false;
-    }
-    // Create a queue for BFS
-    std::list<std::vector<Voxel>> queue;
-    std::vector<Voxel> neighbors;
+    VoxelSearch search(voxel_list, 1);
     Voxel blockee = goal.blockee; // find the blockee
     Voxel blocker = goal.blocker; // don't go under or through blocker
-    std::vector<Voxel> current;
 
-    //Mark the current node as visited and enqueue it
-    visited[seed.z*(nx*ny) + seed.y*ny + seed.x] = true;
-    path.push_back(seed);
-    queue.push_back(path);
-    
-    std::vector<Voxel> final_path;
-    std::vector<Voxel> shortest_path;
     // Add blocker and all things below it to visited
-    // generalize??
-
-    Voxel end = blocker;
+    // Only unassigned voxels are ever reached, so only those in the columns need marking
     Voxel neg_dir(direction.x*-1, direction.y*-1, direction.z*-1);
-    while (end.x < nx && end.x > -1 && end.y > -1 && end.y < ny && end.z > -1 && end.z < nz) {
-        if (debug) {
-            std::cout << "\tsetting " << end.toString() << " to visited" <<std::endl;
-        }
-        visited[end.z*(nx*ny) + end.y*ny + end.x] = true;
-        end += neg_dir;
-    }
-    // add anchors
-    // ok so this is an issue, adding everything below anchors instead of general
-    for (int i = 0; i < anchors.size(); i++) {
-        end = anchors[i];
-        while (end.x < nx && end.x > -1 && end.y > -1 && end.y < ny && end.z > -1 && end.z < nz) {
-            visited[end.z*(nx*ny) + end.y*ny + end.x] = true;
-            end += neg_dir;
-        }
-    }
-    
-    int count = 0;
-    while ( !queue.empty() ) {
-        count++;
-        current = queue.front();
-        if (current.back() == blockee) {
-            shortest_path = current;
-            break; 
-        }
-         
-        queue.pop_front();
-        neighbors = getNeighbors(current.back(), voxel_list, 1);
-        if (debug) {
-            std::cout << "neighbors of " << current.back().toString() << ": " << std::endl;
-            printList(neighbors);
-        }
-        for (int i = 0; i < neighbors.size(); i++) {
-            if ( !visited[ neighbors[i].z*(nx*ny) + neighbors[i].y*ny + neighbors[i].x ] ) {
-                visited[ neighbors[i].z*(nx*ny) + neighbors[i].y*ny + neighbors[i].x ] = true;
-                std::vector<Voxel> new_path = current;
-                new_path.push_back(neighbors[i]);
-                queue.push_back(new_path);
-            }
+    std::vector<Voxel> column;
+    collectAlongRay(voxel_list, blocker, neg_dir, 1, &column);
+    if (debug) {
+        for (int i = 0; i < column.size(); i++) {
+            std::cout << "\tsetting " << column[i].toString() << " to visited" <<std::endl;
         }
     }
+    search.forbid(column);
+    forbidAnchorColumns(voxel_list, &search, anchors, direction);
+
+    std::vector<Voxel> shortest_path = search.pointPath(seed, blockee);
     if (debug) {
         std::cout << "initial path is" << std::endl;
         printList(shortest_path);
     }
-    // add things in the direction
-    for (int i = 0; i < shortest_path.size(); i++) {
-        end = Voxel(shortest_path[i].x, shortest_path[i].y, shortest_path[i].z);
-        final_path.push_back(end);
-        end += direction;
-        while (end.x < nx && end.x > -1 && end.y > -1 && end.y < ny && end.z > -1 && end.z < nz) {
-            if ( voxel_list->isInside(end.x, end.y, end.z) == 1 /*&& !visited[end.z*(nx*ny) + ny*end.y + end.x] */) {
-                final_path.push_back(end);
-            }
-            end += direction;
-        }
-    }
-    if (debug) {
-        std::cout << "final path:" << std::endl;
-        printList(final_path);
+    return sweepPath(voxel_list, shortest_path, direction);
+}
+
+/**
+    Finds a path as short as shortestPath's, answered from a search tree rooted at the seed with the
+    anchor columns already forbidden (see forbidAnchorColumns), so one search serves every goal.
+    The tree doesn't forbid the column behind this goal's blocker. If the tree's path stays out of
+    that column it is also the path a breadth first search restricted to that column would find,
+    since taking cells away can only push other cells later in the search order; otherwise
+    shortestPath is run.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param tree A search tree rooted at seed.
+    @param seed The seed voxel from which the search starts.
+    @param goal The VoxelPair who's blockee voxel we're searching for.
+    @param anchors The anchors the tree was built with.
+    @param direction The direction which the piece is being removed.
+    @return The same list shortestPath would return under PATH_BFS. Other path modes can break
+            ties differently in the fallback.
+*/
+static std::vector<Voxel> shortestPathInTree(CompFab::VoxelGrid * voxel_list, VoxelSearch * tree, Voxel seed, VoxelPair goal, std::vector<Voxel> anchors, Voxel direction) {
+    if (!tree->reach(goal.blockee)) {
+        // Not reachable with fewer cells forbidden, so not reachable at all
+        return std::vector<Voxel>();
     }
-    // Now... make sure that piece is connected after adding things. Otherwise need more path finding.
-    //final_path = ensurePieceConnectivity(voxel_list, final_path, direction);
-    delete[] visited;
-    return final_path;
+    std::vector<Voxel> path = tree->pathTo(goal.blockee);
+    Voxel neg_dir(direction.x*-1, direction.y*-1, direction.z*-1);
+    unsigned int blockerLine = lineKey(voxel_list, goal.blocker, neg_dir);
+    for (int i = 1; i < path.size(); i++) {
+        if (lineKey(voxel_list, path[i], neg_dir) == blockerLine && alongRay(path[i], neg_dir) >= alongRay(goal.blocker, neg_dir)) {
+            return shortestPath(voxel_list, seed, goal, anchors, direction);
+        }
+    }
+    return sweepPath(voxel_list, path, direction);
 }
 
 /**
@@ -532,62 +831,18 @@ std::vector<Voxel> shortestPath(CompFab::VoxelGrid * voxel_list, Voxel seed, Vox
 */
 std::vector<Voxel> findAnchors(CompFab::VoxelGrid * voxel_list, Voxel seed, Voxel normal_one, Voxel normal_two) {
     std::vector<Voxel> anchors;
-    int nx = voxel_list->m_dimX;
-    int ny = voxel_list->m_dimY;
-    int nz = voxel_list->m_dimZ;
+    Voxel anchor;
 
-    if ( normal_one.x != -1 && normal_two.x != -1) {
-        for (int i = 0; i < seed.x; i++) {
-            if (voxel_list->isInside(i, seed.y, seed.z) == 1) {
-                //check connectivity
-                anchors.push_back(Voxel(i, seed.y, seed.z));
-                break;
-            }
-        }
-    }
-    if ( normal_one.x != 1 && normal_two.x != 1) {
-        for (int i = nx-1; i > seed.x; i--) {
-            if (voxel_list->isInside(i, seed.y, seed.z) == 1) {
-                //check connectivity
-                anchors.push_back(Voxel(i, seed.y, seed.z));
-                break;
-            }
-        }
-    }
-    if ( normal_one.y != -1 && normal_two.y != -1) {
-        for (int i = 0; i < seed.y; i++) {
-            if (voxel_list->isInside(seed.x, i, seed.z) == 1) {
-                //check connectivity
-                anchors.push_back(Voxel(seed.x, i, seed.z));
-                break;
-            }
-        }
-    }
-    if ( normal_one.y != 1 && normal_two.y != 1) {
-        for (int i = ny-1; i > seed.y; i--) {
-            if (voxel_list->isInside(seed.x, i, seed.z) == 1) {
-                //check connectivity
-                anchors.push_back(Voxel(seed.x, i, seed.z));
-                break;
-            }
-        }
-    }
-    if ( normal_one.z != -1 && normal_two.z != -1) {
-        for (int i = 0; i < seed.z; i++) {
-            if (voxel_list->isInside(seed.x, seed.y, i) == 1) {
-                //check connectivity
-                anchors.push_back(Voxel(seed.x, seed.y, i));
-                break;
-            }
+    // The anchor on each open side is the unassigned voxel furthest from the seed on that side
+    for (int d = NEG_X; d < NO_DIRECTION; d++) {
+        Voxel dir = directionVoxel((Direction)d);
+        if (normal_one == dir || normal_two == dir) {
+            continue;
         }
-    }
-    if ( normal_one.z != 1 && normal_two.z != 1) {
-        for (int i = nz-1; i > seed.z; i--) {
-            if (voxel_list->isInside(seed.x, seed.y, i) == 1) {
-                //check connectivity
-                anchors.push_back(Voxel(seed.x, seed.y, i));
-                break;
-            }
+        anchor = farthestAlongRay(voxel_list, seed + dir, dir, 1);
+        if (anchor.x != -1) {
+            //check connectivity
+            anchors.push_back(anchor);
         }
     }
     return anchors;
@@ -615,11 +870,15 @@ std::vector<Voxel> filterKey(CompFab::VoxelGrid * voxel_list, AccessibilityGrid
     std::vector<Voxel> anchors = findAnchors(voxel_list, seed, normal_one, normal_two);
     double sum;
     double max_score = std::numeric_limits<double>::max();
+    // Every candidate is searched for from the seed around the same anchors
+    VoxelSearch tree(voxel_list, 1);
+    forbidAnchorColumns(voxel_list, &tree, anchors, Voxel(0, 0, 1));
+    tree.root(seed);
     for (int i = 0; i<candidates.size(); i++) {
         if (debug) {
             std::cout << "finding path to " << candidates[i].blockee.toString() << ", blocker is " << candidates[i].blocker.toString() << std::endl;
         }
-        path = shortestPath(voxel_list, seed, candidates[i], anchors, Voxel(0, 0, 1));
+        path = shortestPathInTree(voxel_list, &tree, seed, candidates[i], anchors, Voxel(0, 0, 1));
         sum = 0;
         for (int j = 0; j < path.size(); j++) {
             sum += scores->score(path[j].x, path[j].y, path[j].z);
@@ -648,11 +907,9 @@ Voxel finalAnchor(CompFab::VoxelGrid * voxel_list, Voxel seed, VoxelPair blocks,
     
     Voxel choice(-1, -1, -1);
 
-    while (!(seed.x <= 0 || seed.x >= nx-1 || seed.y <= 0 || seed.y >= ny-1 || seed.z <= 0 || seed.z >= nz-1)) {
-        seed += normal;
-        if (voxel_list->isInside(seed.x, seed.y, seed.z) == 1) {
-            choice = seed;
-        }
+    // Only seeds off the boundary of the grid look for an anchor
+    if (!(seed.x <= 0 || seed.x >= nx-1 || seed.y <= 0 || seed.y >= ny-1 || seed.z <= 0 || seed.z >= nz-1)) {
+        choice = farthestAlongRay(voxel_list, seed + normal, normal, 1);
     }
 
     if (choice == Voxel(-1, -1, -1)) {
@@ -673,127 +930,47 @@ Voxel finalAnchor(CompFab::VoxelGrid * voxel_list, Voxel seed, VoxelPair blocks,
     @param normal The direction the piece is being removed.
     @return An updated list of voxels that belong to this piece.
 */
-std::vector<Voxel> expandPiece( CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, std::vector<Voxel> key, std::vector<Voxel> anchors, int num_voxels, Voxel normal) {
+Piece expandPiece( CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, Piece key, std::vector<Voxel> anchors, int num_voxels, Voxel normal) {
     if (debug) {
         std::cout << "in expandPiece" << std::endl;
     }
-    int nx = voxel_list->m_dimX;
-    int ny = voxel_list->m_dimY;
-    int nz = voxel_list->m_dimZ;
-    int grid_size = nx*ny*nz;
-
-    std::vector<Voxel> path;
-    // Mark all the vertices as not visited
-    bool *visited = new bool[grid_size];
-    for(unsigned int i=0; i<grid_size; ++i) {
-        visited[i] = false;
-    }
-    // ERROR Z DETECTED
-    Voxel end;
     Voxel neg_dir = Voxel(normal.x*-1, normal.y*-1, normal.z*-1);
+    std::vector<Voxel> column;
     for (int i = 0; i < anchors.size(); i++) {
-        end = anchors[i];
-        while (end.x < nx && end.x > -1 && end.y > -1 && end.y < ny && end.z > -1 && end.z < nz) {
-            visited[end.z*(nx*ny) + end.y*ny + end.x] = true;
-            end += neg_dir;
-        }
+        collectAlongRay(voxel_list, anchors[i], neg_dir, 1, &column);
+    }
+    double B = -2.0;
+    ExpansionFrontier frontier(voxel_list, scores, normal, num_voxels, B);
+    for (int i = 0; i < column.size(); i++) {
+        frontier.take(column[i]);
     }
     for (int i = 0; i < key.size(); i++) {
-        visited[key[i].z*nx*ny + key[i].y*ny + key[i].x] = true;
+        frontier.take(key[i]);
     }
 
     int count = key.size();
     int initial_count = count;
-    std::vector<Voxel> neighbors;
-    std::vector<Voxel> candidates;
-    double sum, dist, random, accum;
-    std::vector<double> probabilities;
-    int total;
-    std::vector<double> access_sums;
-    double B = -2.0;
+    double random;
     int choice = -1;
-    std::vector<Voxel> tempPiece;
+    frontier.grow(key, 0);
     while (count < num_voxels) {
-        for (int i = 0; i< key.size(); i++) {
-            neighbors = getNeighbors(key[i], voxel_list, 1);
-            for (int j = 0; j < neighbors.size(); j++) {
-                if ( !visited[neighbors[j].z*nx*ny + neighbors[j].y*ny + neighbors[j].x] ) {
-                    visited[neighbors[j].z*nx*ny + neighbors[j].y*ny + neighbors[j].x] = true;
-                    candidates.push_back(neighbors[j]);
-                }
-            }
-            neighbors.clear();
-        }
-        if (candidates.size() == 0) {
+        // Only candidates on lines that changed in the last step are scored again
+        frontier.rescore(count);
+        if (frontier.m_live == 0) {
             break;
         }
-        // Get score of candidate additions
-        for (int i = 0; i < candidates.size(); i++) {
-            tempPiece.clear();
-            visited[candidates[i].z*nx*ny + candidates[i].y*ny + candidates[i].x] = false;
-            sum = 0;
-            total = count;
-            
-            // generalize to all
-            end = candidates[i];
-            while (end.x < nx && end.x > -1 && end.y > -1 && end.y < ny && end.z > -1 && end.z < nz) {
-               if ((voxel_list->isInside(end.x, end.y, end.z) == 1) && (!visited[end.z*nx*ny + end.y*ny + end.x] )) {
-                   tempPiece.push_back(end);
-                   total++;
-                   //sum += scores->score(end.x, end.y, end.z);
-                } 
-                end += normal;
-            }
-            tempPiece = ensurePieceConnectivity(voxel_list, tempPiece, normal);
-            for (int j = 0; j < tempPiece.size(); j++) {
-                sum += scores->score(tempPiece[j].x, tempPiece[j].y, tempPiece[j].z);
-            }
-
-            if (total > num_voxels) {
-                continue;
-            }
-            
-            access_sums.push_back(sum);
-        }
-        // Normalize scores
-        dist = 0;
-        for (int i = 0; i < access_sums.size(); i++) {
-            access_sums[i] = std::pow(access_sums[i], B);
-            dist += access_sums[i];
-        }
-        // Find probabilities
-        for (int i = 0; i < access_sums.size(); i++) {
-            probabilities.push_back( access_sums[i] / dist );
-        }
-       
-        // Choose
         random = (double) std::rand() / (RAND_MAX);
-        accum = 0.0;
-        for (int i = 0; i < probabilities.size(); i++) {
-            if ( random < accum + probabilities[i] || probabilities.size() == 1) {
-                choice = i;
-                break;
-            } else {
-                accum += probabilities[i];
-            }
-        }
+        choice = frontier.choose(random);
         // Add choice to the key
-        end = candidates[choice];
-        while (end.x < nx && end.x > -1 && end.y > -1 && end.y < ny && end.z > -1 && end.z < nz) {
-            if ((voxel_list->isInside(end.x, end.y, end.z) == 1) && (!visited[end.z*nx*ny + end.y*ny + end.x] )) {
-                key.push_back(end);
-                visited[end.z*nx*ny + end.y*ny + end.x] = true; 
+        column.clear();
+        collectAlongRay(voxel_list, frontier.m_voxels[choice], normal, 1, &column);
+        for (int i = 0; i < column.size(); i++) {
+            if (!frontier.taken(column[i])) {
+                key.insert(column[i]);
+                frontier.take(column[i]);
             }
-            end += normal;
-        }
-        
-        for (int i = 0; i < key.size(); i++) {
-            visited[key[i].z*nx*ny + key[i].y*ny + key[i].x] = true;
         }
-
-        candidates.clear();
-        access_sums.clear();
-        probabilities.clear();
+        frontier.grow(key, count);
         count = key.size();
     }
     if (debug) {
@@ -810,79 +987,46 @@ std::vector<Voxel> expandPiece( CompFab::VoxelGrid * voxel_list, AccessibilityGr
     @param piece The piece being verified.
     @return true if the piece is connected, false otherwise.
 */
-bool verifyPiece( CompFab::VoxelGrid * voxel_list, std::vector<Voxel> piece) {
+bool verifyPiece( CompFab::VoxelGrid * voxel_list, const Piece & piece) {
     if (debug) {
         std::cout << "in verifyPiece" << std::endl;
     }
+    if (g_remainderOracle != NULL && g_remainderOracle->m_grid == voxel_list) {
+        bool result = g_remainderOracle->staysConnected(piece);
+        // In debug, failures fall through to list what was cut off
+        if (result || !debug) {
+            return result;
+        }
+    }
     int nx = voxel_list->m_dimX;
     int ny = voxel_list->m_dimY;
     int nz = voxel_list->m_dimZ;
-    int grid_size = nx*ny*nz;
-        
 
-    bool *visited = new bool[grid_size];
-    bool *inPiece = new bool[grid_size];
-    for(unsigned int i=0; i<grid_size; ++i) {
-        inPiece[i] = false;
-        visited[i] = false;
-    }
-    
+    // The remainder is every unassigned voxel outside the piece
+    BitVolume remainder(nx, ny, nz);
+    loadUnassigned(voxel_list, &remainder);
     for (int i = 0; i < piece.size(); i++) {
-        inPiece[i] = true;
-        visited[piece[i].z*nx*ny + piece[i].y*ny + piece[i].x] = true;
+        remainder.reset(piece[i]);
     }
-    
-    // Find voxel to start bfs from
-    int x = -1;
-    int y = -1;
-    int z = -1;
-    for (int i = 0; i < nx; i++) {
-        for (int j = 0; j < ny; j++) {
-            for (int k = 0; k < nz; k++) {
-                if (voxel_list->isInside(i, j, k) == 1 && !visited[k*ny*nx + j*ny + i]) {
-                    x = i;
-                    y = j;
-                    z = k;
-                    break;
-                }
-            }
-            if (x != -1) {
-                break;
-            }
-        }
-        if (x != -1) {
-            break;
-        }
+    // Nothing left unassigned
+    if (!remainder.any()) {
+        return true;
     }
 
-    // Now, run bfs
-    Voxel current;
-    std::list<Voxel> queue;
-    std::vector<Voxel> neighbors;
-    visited[z*(nx*ny) + y*ny + x] = true;
-    queue.push_back(Voxel(x, y, z));
-    while (!queue.empty()) {
-        current = queue.front();
-        queue.pop_front();
-        neighbors = getNeighbors(current, voxel_list, 1);
-        for (int i = 0; i < neighbors.size(); i++) {
-            if ( !visited[ neighbors[i].z*(nx*ny) + neighbors[i].y*ny + neighbors[i].x ] ) {
-                visited[ neighbors[i].z*(nx*ny) + neighbors[i].y*ny + neighbors[i].x ] = true;
-                queue.push_back(neighbors[i]);
-            }
-        }
-    }
-    bool result = true;
-    for (int i = 0; i < nx; i++) {
-        for (int j = 0; j < ny; j++) {
-            for (int k = 0; k < nz; k++) {
-                if (voxel_list->isInside(i,j,k) == 1 && !visited[k*(ny*nx) + j*ny + i] ) {
-                    if (debug) {
+    // Now, flood the remainder from any one of its voxels
+    BitVolume reach(nx, ny, nz);
+    reach.set(remainder.first());
+    floodFill(remainder, &reach);
+    bool result = reach.covers(remainder);
+    if (debug && !result) {
+        for (int i = 0; i < nx; i++) {
+            for (int j = 0; j < ny; j++) {
+                for (int k = 0; k < nz; k++) {
+                    if (remainder.test(Voxel(i, j, k)) && !reach.test(Voxel(i, j, k))) {
                         std::cout << "piece could not be verfied due to " << Voxel(i,j,k).toString() << std::endl;
                     }
-                    result = false;
                 }
-             }
+            }
         }
     }
     return result;
@@ -896,41 +1040,18 @@ bool verifyPiece( CompFab::VoxelGrid * voxel_list, std::vector<Voxel> piece) {
     @param piece The previous piece in the puzzle.
     @return The direction from which the piece will be removed.
 */
-Voxel findNormalDirection( CompFab::VoxelGrid * voxel_list, Voxel voxel, std::vector<Voxel> piece) {
+Voxel findNormalDirection( CompFab::VoxelGrid * voxel_list, Voxel voxel, const Piece & piece) {
     if (debug) {
         std::cout << "in findNormalDirection" << std::endl;
     }
-    int nx = voxel_list->m_dimX;
-    int ny = voxel_list->m_dimY;
-    int nz = voxel_list->m_dimZ;
-    int size = nx*ny*nz;
-    
-    bool *visited = new bool[size];
-    for(unsigned int i=0; i<size; ++i) {
-        visited[i] = false;
-    }
-    
-    // set voxels of piece to true
-    for (int i = 0; i < piece.size(); i++) {
-        visited[piece[i].z*ny*nx + piece[i].y*ny + piece[i].x] = true;
-    }
-    
-    if (visited[voxel.z*ny*nx + voxel.y*ny + voxel.x-1]) {
-        return Voxel(-1, 0, 0);
-    } else if (visited[voxel.z*ny*nx + voxel.y*ny + voxel.x+1]) {
-        return Voxel(1, 0, 0);
-    } else if (visited[voxel.z*ny*nx + (voxel.y-1)*ny + voxel.x]) {
-        return Voxel(0, -1, 0);
-    } else if (visited[voxel.z*ny*nx + (voxel.y+1)*ny + voxel.x]) {
-        return Voxel(0, 1, 0);
-    } else if (visited[(voxel.z-1)*ny*nx + voxel.y*ny + voxel.x]) {
-        return Voxel(0, 0, -1);
-    } else if (visited[(voxel.z+1)*ny*nx + voxel.y*ny + voxel.x]) {
-        return Voxel(0, 0, 1);
-    } else {
-        std::cout << "Error finding normal" << std::endl;
-        return Voxel(-1,-1,-1);
+    for (int d = NEG_X; d < NO_DIRECTION; d++) {
+        Voxel next = voxel + directionVoxel((Direction)d);
+        if (piece.contains(next)) {
+            return directionVoxel((Direction)d);
+        }
     }
+    std::cout << "Error finding normal" << std::endl;
+    return Voxel(-1,-1,-1);
 } 
 
 /**
@@ -951,7 +1072,7 @@ bool voxelSortSorter(VoxelSort i, VoxelSort j) { return (i.score < j.score); }
     @param piece The previous piece.
     @return A list of potential seeds sorted by their accessibility scores.
 */
-std::vector<Voxel> seedSorter(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, std::vector<Voxel> seeds, std::vector<Voxel> piece) {
+std::vector<Voxel> seedSorter(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, std::vector<Voxel> seeds, const Piece & piece) {
     if (debug) {
         std::cout << "in seedSorter" << std::endl;
     }
@@ -964,19 +1085,18 @@ std::vector<Voxel> seedSorter(CompFab::VoxelGrid * voxel_list, AccessibilityGrid
     double max_dist_double = 0.0;
     double max_access = 0.0;
     int indiv_dist;
+    std::vector<int> distances;
     // find max distance
     Voxel normal;
     Voxel end;
     for (int i = 0; i < seeds.size(); i++) {
         normal = findNormalDirection( voxel_list, seeds[i], piece);
         indiv_dist = 0;
-        end = Voxel(seeds[i].x, seeds[i].y, seeds[i].z);
-        for (int j = 0; end.x < nx && end.x > -1 && end.y > -1 && end.y < ny && end.z > -1 && end.z < nz ; j++) {
-            if (voxel_list->isInside(end.x, end.y, end.z) == 1) {
-                indiv_dist = j;
-            }
-            end += normal;
+        end = farthestAlongRay(voxel_list, seeds[i], normal, 1);
+        if (end.x != -1) {
+            indiv_dist = std::max(std::abs(end.x - seeds[i].x), std::max(std::abs(end.y - seeds[i].y), std::abs(end.z - seeds[i].z)));
         }
+        distances.push_back(indiv_dist);
         if ( max_distance < indiv_dist) {
             max_distance = indiv_dist;
         }
@@ -993,16 +1113,7 @@ std::vector<Voxel> seedSorter(CompFab::VoxelGrid * voxel_list, AccessibilityGrid
     double this_dist;
     for (int i = 0; i < seeds.size(); i++) {
         this_score = scores->score( seeds[i].x, seeds[i].y, seeds[i].z ) / max_access;
-        
-        normal = findNormalDirection( voxel_list, seeds[i], piece);
-        indiv_dist = 0;
-        for (int j = 0; end.x < nx && end.x > -1 && end.y > -1 && end.y < ny && end.z > -1 && end.z < nz ; j++) {
-            if (voxel_list->isInside(end.x, end.y, end.z) == 1) {
-                indiv_dist = j;
-            }
-            end += normal;
-        }
-        this_dist = (double)indiv_dist / max_dist_double;
+        this_dist = (double)distances[i] / max_dist_double;
         voxels.push_back(VoxelSort(seeds[i], this_score+this_dist));
     }
 
@@ -1023,7 +1134,7 @@ std::vector<Voxel> seedSorter(CompFab::VoxelGrid * voxel_list, AccessibilityGrid
     @param perpendicular The directions from which the next piece cannot be removed.
     @return A list of potential seeds for the next piece.
 */
-std::vector<Voxel> findCandidateSeeds(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, std::vector<Voxel> piece, Voxel perpendicular) {
+std::vector<Voxel> findCandidateSeeds(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, const Piece & piece, Voxel perpendicular) {
     if (debug) {
         std::cout << "in findCandidateSeeds" << std::endl;
     }
@@ -1034,16 +1145,13 @@ std::vector<Voxel> findCandidateSeeds(CompFab::VoxelGrid * voxel_list, Accessibi
     int size = nx*ny*nz;
     Voxel voxel;
     // Mark all the vertices as not visited
-    bool *visited = new bool[size];
-    for(unsigned int i=0; i<size; ++i) {
-        visited[i] = false;
-    }
+    ScratchLease visited(size);
     for (int i = 0; i < piece.size(); i++) {
-        visited[piece[i].z*ny*nx + piece[i].y*ny + piece[i].x] = true;
+        visited->mark(piece[i].z*ny*nx + piece[i].y*ny + piece[i].x);
         // mark all pieces in normal direction as visited too
         voxel = piece[i] + Voxel(-1*perpendicular.x, -1*perpendicular.y, -1*perpendicular.z);
         if ( voxel.x > -1 && voxel.x < nx && voxel.y > -1 && voxel.y < ny && voxel.z > -1 && voxel.z < nz ) {
-            visited[voxel.z*ny*nx + voxel.y*ny + voxel.x] = true;
+            visited->mark(voxel.z*ny*nx + voxel.y*ny + voxel.x);
         }
     }
 
@@ -1052,8 +1160,8 @@ std::vector<Voxel> findCandidateSeeds(CompFab::VoxelGrid * voxel_list, Accessibi
         voxel = Voxel(piece[i].x, piece[i].y, piece[i].z);
         
         if ( voxel.x != 0) {
-            if (voxel_list->isInside(voxel.x-1,voxel.y,voxel.z) == 1 && !visited[voxel.z*ny*nx + voxel.y*ny + voxel.x-1]) {
-                visited[voxel.z*ny*nx + voxel.y*ny + voxel.x-1] = true;
+            if (voxel_list->isInside(voxel.x-1,voxel.y,voxel.z) == 1 && !visited->marked(voxel.z*ny*nx + voxel.y*ny + voxel.x-1)) {
+                visited->mark(voxel.z*ny*nx + voxel.y*ny + voxel.x-1);
                 if (perpendicular.x == 0) {
                     neighbors.push_back(Voxel(voxel.x-1,voxel.y,voxel.z));
                 }
@@ -1061,8 +1169,8 @@ std::vector<Voxel> findCandidateSeeds(CompFab::VoxelGrid * voxel_list, Accessibi
         }
         
         if ( voxel.x != nx-1) {
-            if (voxel_list->isInside(voxel.x+1,voxel.y,voxel.z) == 1 && !visited[voxel.z*ny*nx + voxel.y*ny + voxel.x+1]) {
-                visited[voxel.z*ny*nx + voxel.y*ny + voxel.x+1] = true;
+            if (voxel_list->isInside(voxel.x+1,voxel.y,voxel.z) == 1 && !visited->marked(voxel.z*ny*nx + voxel.y*ny + voxel.x+1)) {
+                visited->mark(voxel.z*ny*nx + voxel.y*ny + voxel.x+1);
                 if (perpendicular.x == 0) {
                     neighbors.push_back(Voxel(voxel.x+1,voxel.y,voxel.z));
                 }
@@ -1070,8 +1178,8 @@ std::vector<Voxel> findCandidateSeeds(CompFab::VoxelGrid * voxel_list, Accessibi
         }
         
         if (voxel.y != 0) {
-            if (voxel_list->isInside(voxel.x,voxel.y-1,voxel.z) == 1 && !visited[voxel.z*ny*nx + (voxel.y-1)*ny + voxel.x]) {
-                visited[voxel.z*ny*nx + (voxel.y-1)*ny + voxel.x] = true;
+            if (voxel_list->isInside(voxel.x,voxel.y-1,voxel.z) == 1 && !visited->marked(voxel.z*ny*nx + (voxel.y-1)*ny + voxel.x)) {
+                visited->mark(voxel.z*ny*nx + (voxel.y-1)*ny + voxel.x);
                 if (perpendicular.y == 0) {
                     neighbors.push_back(Voxel(voxel.x,voxel.y-1,voxel.z));
                 }
@@ -1079,8 +1187,8 @@ std::vector<Voxel> findCandidateSeeds(CompFab::VoxelGrid * voxel_list, Accessibi
         }
         
         if (voxel.y != ny-1) {
-            if (voxel_list->isInside(voxel.x,voxel.y+1,voxel.z) == 1 && !visited[voxel.z*ny*nx + (voxel.y+1)*ny + voxel.x]) {
-                visited[voxel.z*ny*nx + (voxel.y+1)*ny + voxel.x] = true;
+            if (voxel_list->isInside(voxel.x,voxel.y+1,voxel.z) == 1 && !visited->marked(voxel.z*ny*nx + (voxel.y+1)*ny + voxel.x)) {
+                visited->mark(voxel.z*ny*nx + (voxel.y+1)*ny + voxel.x);
                 if (perpendicular.y == 0) {
                     neighbors.push_back(Voxel(voxel.x,voxel.y+1,voxel.z));
                 }
@@ -1088,16 +1196,16 @@ std::vector<Voxel> findCandidateSeeds(CompFab::VoxelGrid * voxel_list, Accessibi
         }
         
         if (voxel.z != 0) {
-            if (voxel_list->isInside(voxel.x,voxel.y,voxel.z-1) == 1 && !visited[(voxel.z-1)*ny*nx + voxel.y*ny + voxel.x]) {
-                visited[(voxel.z-1)*ny*nx + voxel.y*ny + voxel.x] = true;
+            if (voxel_list->isInside(voxel.x,voxel.y,voxel.z-1) == 1 && !visited->marked((voxel.z-1)*ny*nx + voxel.y*ny + voxel.x)) {
+                visited->mark((voxel.z-1)*ny*nx + voxel.y*ny + voxel.x);
                 if (perpendicular.z == 0) {
                     neighbors.push_back(Voxel(voxel.x,voxel.y,voxel.z-1));
                 }
             }
         }
         if (voxel.z != nz-1) {
-            if (voxel_list->isInside(voxel.x,voxel.y,voxel.z+1) == 1 && !visited[(voxel.z+1)*ny*nx + voxel.y*ny + voxel.x]) {
-                visited[(voxel.z+1)*ny*nx + voxel.y*ny + voxel.x] = true;
+            if (voxel_list->isInside(voxel.x,voxel.y,voxel.z+1) == 1 && !visited->marked((voxel.z+1)*ny*nx + voxel.y*ny + voxel.x)) {
+                visited->mark((voxel.z+1)*ny*nx + voxel.y*ny + voxel.x);
                 if (perpendicular.z == 0) {
                     neighbors.push_back(Voxel(voxel.x,voxel.y,voxel.z+1));
                 }
@@ -1137,46 +1245,9 @@ std::vector<Voxel> shortestPathTwo(CompFab::VoxelGrid * voxel_list, Voxel start,
         std::cout << "in shortestPathTwo" << std::endl;
         std::cout << "start is " << start.toString() << ", goal is " << goal.toString() << std::endl;
     }
-    int nx = voxel_list->m_dimX;
-    int ny = voxel_list->m_dimY;
-    int nz = voxel_list->m_dimZ;
-    int size = nx*ny*nz;
-
-    bool *visited = new bool[size];
-    for (int i = 0; i < size; i++) {
-        visited[i] = false;
-    }
-    std::list<std::vector<Voxel>> queue;
-    std::vector<Voxel> neighbors;
-    std::vector<Voxel> current;
-    std::vector<Voxel> path;
-
-    //Mark the current node as visited and enqueue it
-    visited[start.z*(nx*ny) + start.y*ny + start.x] = true;
-    path.push_back(start);
-    queue.push_back(path);
-
-    std::vector<Voxel> shortest_path;
-
-    while ( !queue.empty() ) {
-        current = queue.front();
-        if (current.back() == goal) {
-            shortest_path = current;
-            break;
-        }
-
-        queue.pop_front();
-        neighbors = getNeighbors(current.back(), voxel_list, 1);
-        for (int i = 0; i < neighbors.size(); i++) {
-            if ( !visited[ neighbors[i].z*(nx*ny) + neighbors[i].y*ny + neighbors[i].x ] ) {
-                visited[ neighbors[i].z*(nx*ny) + neighbors[i].y*ny + neighbors[i].x ] = true;
-                std::vector<Voxel> new_path = current;
-                new_path.push_back(neighbors[i]);
-                queue.push_back(new_path);
-            }
-        }
-    }
-    if (queue.empty()) {
+    VoxelSearch search(voxel_list, 1);
+    std::vector<Voxel> shortest_path = search.pointPath(start, goal);
+    if (shortest_path.empty()) {
         std::cout << "\n\n\t\tFAILED FINDING PATH\n\t\tFAILED FINDING PATH\n\t\tFAILED FINDING PATH\n\n" << std::endl;
     }
     return shortest_path;
@@ -1192,7 +1263,7 @@ std::vector<Voxel> shortestPathTwo(CompFab::VoxelGrid * voxel_list, Voxel start,
     @param index An integer pointer that gets set to the index of the chosen candidate.
     @return A list containing the initial construction of the next piece.
 */
-std::vector<Voxel> createInitialPiece(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, std::vector<Voxel> prevPiece, std::vector<Voxel> candidates, int * index) {
+Piece createInitialPiece(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, const Piece & prevPiece, std::vector<Voxel> candidates, int * index) {
     if (debug) {
         std::cout << "in createInitialPiece" << std::endl;
     }
@@ -1201,17 +1272,15 @@ std::vector<Voxel> createInitialPiece(CompFab::VoxelGrid * voxel_list, Accessibi
     int nz = voxel_list->m_dimZ;
     int size = nx*ny*nz;
     
-    std::vector<Voxel> bestChoice;
-    std::vector<Voxel> currentChoice;
+    Piece bestChoice;
+    Piece currentChoice;
     std::vector<Voxel> toRemove;
     double bestScore = std::numeric_limits<double>::max();
     double currentScore;
     Voxel normal;
     Voxel end;
-    bool *visited = new bool[size];
     std::vector<Voxel> shortestPath;
     std::vector<Voxel> finalPath;
-    bool in;
     for (int i = 0; i < candidates.size(); i++) {
         //std::cout << "checking candidate " << candidates[i].toString() << std::endl;
         // Reset everything
@@ -1222,22 +1291,16 @@ std::vector<Voxel> createInitialPiece(CompFab::VoxelGrid * voxel_list, Accessibi
 
         // Find the normal
         normal = findNormalDirection( voxel_list, candidates[i], prevPiece);
-        end = candidates[i] + normal;
         //std::cout << "\tnormal is " << normal.toString() << std::endl;
         // Figure out what voxels must be added in the normal direction
-        //std::cout << "\tfinding the voxels to add" << std::endl;
-        for (int j = 0; end.x < nx && end.x > -1 && end.y > -1 && end.y < ny && end.z > -1 && end.z < nz ; j++) {
-            //std::cout << "\tchecking " << end.toString() << std::endl;
-            if (voxel_list->isInside(end.x, end.y, end.z) == 1) {
-                //std::cout << "\t\t" << end.toString() << " must be removed" << std::endl;
-                toRemove.push_back(end); 
-            }
-            end += normal;
-        }
+        collectAlongRay(voxel_list, candidates[i] + normal, normal, 1, &toRemove);
+        // Paths to all of them come from one search rooted at the candidate
+        VoxelSearch tree(voxel_list, 1);
+        tree.root(candidates[i]);
         
         if (toRemove.size() == 0) {
             currentScore = scores->score(candidates[i].x, candidates[i].y, candidates[i].z);
-            currentChoice.push_back(candidates[i]);
+            currentChoice.insert(candidates[i]);
             /*if (currentScore < bestScore) {
                 bestScore = currentScore;
                 currentChoice.push_back(candidates[i]);
@@ -1251,7 +1314,12 @@ std::vector<Voxel> createInitialPiece(CompFab::VoxelGrid * voxel_list, Accessibi
 
         // Now, find shortest path to each of these and add said path to the piece
         for (int j = 0; j < toRemove.size(); j++) {
-            shortestPath = shortestPathTwo(voxel_list, candidates[i], toRemove[j]);
+            shortestPath.clear();
+            if (tree.reach(toRemove[j])) {
+                shortestPath = tree.pathTo(toRemove[j]);
+            } else {
+                std::cout << "\n\n\t\tFAILED FINDING PATH\n\t\tFAILED FINDING PATH\n\t\tFAILED FINDING PATH\n\n" << std::endl;
+            }
             //std::cout << "\tpath to " << toRemove[j].toString() << " is: " << std::endl;
             if (shortestPath.size() == 0) {
                 std::cout << "Something went wrong" << std::endl;
@@ -1261,27 +1329,11 @@ std::vector<Voxel> createInitialPiece(CompFab::VoxelGrid * voxel_list, Accessibi
             }
             // add all voxels in normal direction
             for (int k = 0; k < shortestPath.size(); k++) {
-                end = shortestPath[k];
-                for (int l = 0; end.x < nx && end.x > -1 && end.y > -1 && end.y < ny && end.z > -1 && end.z < nz ; l++) {
-                    if (voxel_list->isInside(end.x, end.y, end.z) == 1) {
-                        finalPath.push_back(end);
-                    }
-                    end += normal;
-                }
+                collectAlongRay(voxel_list, shortestPath[k], normal, 1, &finalPath);
             }
             // add path to the piece
             for (int k = 0; k < finalPath.size(); k++) {
-                // Check if it's already in there
-                in = false;
-                for (int l = 0; l < currentChoice.size(); l++) {
-                    if (finalPath[k] == currentChoice[l]) {
-                        in = true;
-                        break;
-                    }
-                }
-                if ( !in ) {
-                    currentChoice.push_back(finalPath[k]);
-                }
+                currentChoice.insert(finalPath[k]);
             }
         }
 
@@ -1333,38 +1385,32 @@ std::vector<Voxel>  bfsTwo(CompFab::VoxelGrid * voxel_list, AccessibilityGrid *
 
 
     // Mark all the vertices as not visited
-    bool *visited = new bool[size];
-    for(unsigned int i=0; i<size; ++i) {
-        visited[i] = false;
-    }
+    ScratchLease visited(size);
 
     // Create a queue for BFS
-    std::list<Voxel> queue;
-    std::vector<Voxel> neighbors;
+    IndexQueue & queue = visited->m_queue;
     Voxel blockee;
     Voxel blocker;
     //Mark the current node as visited and enqueue it
-    visited[seed.z*(nx*ny) + seed.y*ny + seed.x] = true;
-    queue.push_back(seed);
+    visited->mark(voxelIndex(voxel_list, seed));
+    queue.push(voxelIndex(voxel_list, seed));
 
     int count = 0;
     while (!queue.empty() && potentials.size() < nb_one) {
         count++;
-        blockee = queue.front();
+        blockee = voxelAt(voxel_list, queue.front());
         blocker = blockee + toBlock;
         if (blocker.x < 0 || blocker.x >= nx || blocker.y < 0 || blocker.y >= ny || blocker.z < 0 || blocker.z >= nz) {
             ;
         } else if (voxel_list->isInside(blocker.x, blocker.y, blocker.z) == 1 && blocker != seed) {
             potentials.push_back(VoxelPair(blocker, scores->score(blocker.x, blocker.y, blocker.z), blockee, scores->score(blockee.x, blockee.y, blockee.z)));
         }
-        queue.pop_front();
-        neighbors = getNeighbors(blockee, voxel_list, 1);
-        for (int i = 0; i < neighbors.size(); i++) {
-            if ( !visited[ neighbors[i].z*(nx*ny) + neighbors[i].y*ny + neighbors[i].x ] ) {
-                visited[ neighbors[i].z*(nx*ny) + neighbors[i].y*ny + neighbors[i].x ] = true;
-                queue.push_back(neighbors[i]);
+        queue.pop();
+        forEachNeighbor(voxel_list, blockee, 1, [&](const Voxel & next, unsigned int index) {
+            if (visited->testAndMark(index)) {
+                queue.push(index);
             }
-        }
+        });
     }
     if (debug) {
         std::cout << "in bfsTwo, went through: " << count << std::endl;
@@ -1386,46 +1432,38 @@ std::vector<Voxel>  bfsTwo(CompFab::VoxelGrid * voxel_list, AccessibilityGrid *
 
     Voxel current;
     bool skip;
+    BitVolume unassigned(nx, ny, nz);
+    BitVolume remainder(nx, ny, nz);
+    BitVolume reach(nx, ny, nz);
+    if (!accessible.empty()) {
+        loadUnassigned(voxel_list, &unassigned);
+    }
+    VoxelSearch tree(voxel_list, 1);
+    forbidAnchorColumns(voxel_list, &tree, anchorList, normal);
+    tree.root(seed);
     for (int i = 0; i < accessible.size(); i++) {
-        currentPiece = shortestPath(voxel_list, seed, accessible[i], anchorList, normal);
+        currentPiece = shortestPathInTree(voxel_list, &tree, seed, accessible[i], anchorList, normal);
         if (debug) {
             std::cout<< "path from " << seed.toString() << " to " << accessible[i].blockee.toString() << std::endl;
         }
 
         // Verify that the blocker isn't isolated, i.e. that it can access rest of puzzle not through the piece
-        for(unsigned int j=0; j<size; ++j) {
-            visited[j] = false;
-        }
+        remainder = unassigned;
         for (int j = 0; j < currentPiece.size(); j++) {
-            visited[ currentPiece[j].z*(ny*nx) + currentPiece[j].y*ny + currentPiece[j].x ] = true;
-        }
-        queue.clear();
-        queue.push_back(accessible[i].blocker);
-        while (!queue.empty()) {
-            current = queue.front();
-            queue.pop_front();
-            neighbors = getNeighbors(current, voxel_list, 1);
-            for (int k = 0; k < neighbors.size(); k++) {
-                if ( !visited[ neighbors[k].z*(nx*ny) + neighbors[k].y*ny + neighbors[k].x ] ) {
-                    visited[ neighbors[k].z*(nx*ny) + neighbors[k].y*ny + neighbors[k].x ] = true;
-                    queue.push_back(neighbors[k]);
-                }
-            }
+            remainder.reset(currentPiece[j]);
         }
+        // The search starts from the blocker's neighbors, so the blocker only counts as reached if it
+        // can be stepped back into
+        reach.clear();
+        forEachNeighbor(voxel_list, accessible[i].blocker, 1, [&](const Voxel & next, unsigned int index) {
+            reach.set(next);
+        });
+        floodFill(remainder, &reach);
 
         // Finally, make sure everything in puzzle was visited
-        skip = false;
-        for (int x = 0; x < nx; x++) {
-            for (int y = 0; y < ny; y++) {
-                for (int z = 0; z < nz; z++) {
-                    if ((voxel_list->isInside(x, y, z) == 1) && !visited[z*(ny*nx) + y*ny + x]) {
-                        skip = true;
-                        if (debug) {
-                            std::cout << "bad blocker is " << accessible[i].blocker.toString() << std::endl;
-                        }
-                     }
-                }
-            }
+        skip = !reach.covers(remainder);
+        if (skip && debug) {
+            std::cout << "bad blocker is " << accessible[i].blocker.toString() << std::endl;
         }
         
         if (skip) continue;
@@ -1470,43 +1508,50 @@ std::vector<Voxel>  bfsTwo(CompFab::VoxelGrid * voxel_list, AccessibilityGrid *
     @param anchorList A list of anchors which the piece cannot travel through.
     @return An updated version of the current piece, only changed if it was not blocked in direction dir.
 */
-std::vector<Voxel> mobilityCheck(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, std::vector<Voxel> prevPiece, std::vector<Voxel> currentPiece, int prevPieceId, Voxel dir, Voxel normal, Voxel prevNormal, Voxel * anchor, std::vector<Voxel> anchorList) {
+Piece mobilityCheck(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, const Piece & prevPiece, Piece currentPiece, int prevPieceId, Voxel dir, Voxel normal, Voxel prevNormal, Voxel * anchor, std::vector<Voxel> anchorList) {
     if (debug) {
         std::cout << "checking mobility in dir " << dir.toString() << std::endl;
     }
     int count = currentPiece.size();
-    
-    int nx = voxel_list->m_dimX;
-    int ny = voxel_list->m_dimY;
-    int nz = voxel_list->m_dimZ;
-    int size = nx*ny*nz;
-
-    bool *isCurrent = new bool[size];
-    for(unsigned int i=0; i<size; ++i) {
-        isCurrent[i] = false;
-    }
-    
-    for (int i = 0; i < currentPiece.size(); i++) {
-        isCurrent[currentPiece[i].z*(ny*nx) + currentPiece[i].y*ny + currentPiece[i].x] = true;
-    }
 
     bool blocked = false;
-    bool in;
-    Voxel end;
     std::vector<Voxel> path;
+
+    // The rays from all of the piece's voxels on one line along dir are covered by the ray from the
+    // rearmost of them, so each line is checked once
+    std::unordered_map<unsigned int, Voxel> rearmost;
+    std::unordered_map<unsigned int, int> unassignedOnLine;
+    unsigned int line;
     for (int i = 0; i < currentPiece.size(); i++) {
-        end = currentPiece[i];
-        while (end.x < nx && end.x > -1 && end.y > -1 && end.y < ny && end.z > -1 && end.z < nz && !blocked) { 
-            if (voxel_list->isInside(end.x, end.y, end.z) == 1 || ((voxel_list->isInside(end.x, end.y, end.z) == prevPieceId) && (dir != prevNormal)) ) {
-                if (!isCurrent[end.z*(ny*nx) + end.y*ny + end.x]) {
-                    //*anchor = end;
-                    blocked = true;
-                }
-            }
-            end += dir;
+        line = lineKey(voxel_list, currentPiece[i], dir);
+        std::unordered_map<unsigned int, Voxel>::iterator it = rearmost.find(line);
+        if (it == rearmost.end()) {
+            rearmost[line] = currentPiece[i];
+        } else if (alongRay(currentPiece[i], dir) < alongRay(it->second, dir)) {
+            it->second = currentPiece[i];
         }
-        if (blocked) {
-            break;
+        if (voxel_list->isInside(currentPiece[i].x, currentPiece[i].y, currentPiece[i].z) == 1) {
+            unassignedOnLine[line]++;
+        }
+    }
+    // Blocked by an unassigned voxel that isn't part of the piece
+    for (std::unordered_map<unsigned int, Voxel>::iterator it = rearmost.begin(); it != rearmost.end() && !blocked; ++it) {
+        if (countAlongRay(voxel_list, it->second, dir, 1) > unassignedOnLine[it->first]) {
+            //*anchor = end;
+            blocked = true;
+        }
+    }
+    // Blocked by the previous piece, unless it is removed in this same direction
+    if (!blocked && dir != prevNormal) {
+        for (int i = 0; i < prevPiece.size(); i++) {
+            if (voxel_list->isInside(prevPiece[i].x, prevPiece[i].y, prevPiece[i].z) != prevPieceId || currentPiece.contains(prevPiece[i])) {
+                continue;
+            }
+            std::unordered_map<unsigned int, Voxel>::iterator it = rearmost.find(lineKey(voxel_list, prevPiece[i], dir));
+            if (it != rearmost.end() && alongRay(prevPiece[i], dir) >= alongRay(it->second, dir)) {
+                blocked = true;
+                break;
+            }
         }
     }
 
@@ -1518,18 +1563,7 @@ std::vector<Voxel> mobilityCheck(CompFab::VoxelGrid * voxel_list, AccessibilityG
         //std::cout << "BEST CHOICE IS " << std::endl;
         //printList(path);
         for (int i = 0; i < path.size(); i++) {
-            in = false;
-            //std::cout << "\tchecking if " << path[i].toString() << "is already in piece" << std::endl;
-            for (int j = 0; j < currentPiece.size(); j++) {
-                if (path[i] == currentPiece[j]) {
-                    //std::cout << "\t\t" << path[i].toString() << " is in current piece already" << std::endl;
-                    in = true;
-                    break;
-                }
-            }
-            if ( !in ) {
-                currentPiece.push_back(path[i]);
-            }
+            currentPiece.insert(path[i]);
         }
     }
     if (currentPiece.size() == count) {
@@ -1556,7 +1590,7 @@ std::vector<Voxel> mobilityCheck(CompFab::VoxelGrid * voxel_list, AccessibilityG
     @param theAnchors A pointer to a voxel vector that gets updated with the voxels that cannot be added to this piece.
     @return An udpated version of the piece that is only mobile in one direction.
 */
-std::vector<Voxel> ensureInterlocking(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, std::vector<Voxel> prevPiece, std::vector<Voxel> currentPiece, int prevPieceId, Voxel prevNormal, std::vector<Voxel> * theAnchors) {
+Piece ensureInterlocking(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, const Piece & prevPiece, Piece currentPiece, int prevPieceId, Voxel prevNormal, std::vector<Voxel> * theAnchors) {
     if (debug) {
         std::cout << "in ensureInterlocking" << std::endl;
     }
@@ -1568,52 +1602,17 @@ std::vector<Voxel> ensureInterlocking(CompFab::VoxelGrid * voxel_list, Accessibi
     // Perform mobility check in each of the other 5 directions
     Voxel anchor;
     std::vector<Voxel> anchorList;
-    if (normal.x != -1) {
-        dir = Voxel(-1, 0, 0);
-        anchor = Voxel(-1, -1, -1);
-        currentPiece = mobilityCheck(voxel_list, scores, prevPiece, currentPiece, prevPieceId, dir, normal, prevNormal, &anchor, anchorList);
-        if (anchor != Voxel(-1, -1, -1)) {
-            anchorList.push_back(anchor);
-        }
-    }
-    if (normal.x != 1) {
-        dir = Voxel(1, 0, 0);
-        anchor = Voxel(-1, -1, -1);
-        currentPiece = mobilityCheck(voxel_list, scores, prevPiece, currentPiece, prevPieceId, dir, normal, prevNormal, &anchor, anchorList);
-        if (anchor != Voxel(-1, -1, -1)) {
-            anchorList.push_back(anchor);
-        }
-    }
-    if (normal.y != -1) {
-        dir = Voxel(0, -1, 0);
-        anchor = Voxel(-1, -1, -1);
-        currentPiece = mobilityCheck(voxel_list, scores, prevPiece, currentPiece, prevPieceId, dir, normal, prevNormal, &anchor, anchorList);
-        if (anchor != Voxel(-1, -1, -1)) {
-            anchorList.push_back(anchor);
+    for (int d = NEG_X; d < NO_DIRECTION; d++) {
+        dir = directionVoxel((Direction)d);
+        if (alongRay(normal, dir) == 1) {
+            continue;
         }
-    }
-    if (normal.y != 1) {
-        dir = Voxel(0, 1, 0);
         anchor = Voxel(-1, -1, -1);
         currentPiece = mobilityCheck(voxel_list, scores, prevPiece, currentPiece, prevPieceId, dir, normal, prevNormal, &anchor, anchorList);
         if (anchor != Voxel(-1, -1, -1)) {
             anchorList.push_back(anchor);
         }
     }
-    if (normal.z != -1) {
-        dir = Voxel(0, 0, -1);
-        currentPiece = mobilityCheck(voxel_list, scores, prevPiece, currentPiece, prevPieceId, dir, normal, prevNormal, &anchor, anchorList);
-        if (anchor != Voxel(-1, -1, -1)) {
-            anchorList.push_back(anchor);
-        }
-    }
-    if (normal.z != 1) {
-        dir = Voxel(0, 0, 1);
-        currentPiece = mobilityCheck(voxel_list, scores, prevPiece, currentPiece, prevPieceId, dir, normal, prevNormal, &anchor, anchorList);
-        if (anchor != Voxel(-1, -1, -1)) {
-            anchorList.push_back(anchor);
-        }
-    }
     *theAnchors = anchorList;
     return currentPiece;
 }
@@ -1626,63 +1625,16 @@ std::vector<Voxel> ensureInterlocking(CompFab::VoxelGrid * voxel_list, Accessibi
     @param goals The piece we're finding a path to.
     @return The path from voxel start to a piece.
 */
-std::vector<Voxel> shortestPathThree(CompFab::VoxelGrid * voxel_list, Voxel start, std::vector<Voxel> goals) {
+std::vector<Voxel> shortestPathThree(CompFab::VoxelGrid * voxel_list, Voxel start, const Piece & goals) {
     if (debug) {
         std::cout << "in shortestPathThree" << std::endl;
         std::cout << "starting from " << start.toString() << std::endl;
     }
-    int nx = voxel_list->m_dimX;
-    int ny = voxel_list->m_dimY;
-    int nz = voxel_list->m_dimZ;
-    int size = nx*ny*nz;
-
-    bool *visited = new bool[size];
-    for (int i = 0; i < size; i++) {
-        visited[i] = false;
-    }
-    
-    bool *piece = new bool[size];
-    for (int i =0; i < size; i++) {
-        piece[i] = false;
-    }
-
-    for (int i = 0; i < goals.size(); i++) {
-        piece[goals[i].z*(ny*nx) + goals[i].y*ny + goals[i].x] = true;
-    }
-    piece[start.z*(nx*ny) + start.y*ny + start.x] = false;
-
-    std::list<std::vector<Voxel>> queue;
-    std::vector<Voxel> neighbors;
-    std::vector<Voxel> current;
-    std::vector<Voxel> path;
-
-    //Mark the current node as visited and enqueue it
-    visited[start.z*(nx*ny) + start.y*ny + start.x] = true;
-    path.push_back(start);
-    queue.push_back(path);
-
-    std::vector<Voxel> shortest_path;
-    Voxel back;
-    while ( !queue.empty() ) {
-        current = queue.front();
-        back = current.back();
-        if ( piece[back.z*(ny*nx) + back.y*ny + back.x] ) {
-            shortest_path = current;
-            break;
-        }
-
-        queue.pop_front();
-        neighbors = getNeighbors(current.back(), voxel_list, 1);
-        for (int i = 0; i < neighbors.size(); i++) {
-            if ( !visited[ neighbors[i].z*(nx*ny) + neighbors[i].y*ny + neighbors[i].x ] ) {
-                visited[ neighbors[i].z*(nx*ny) + neighbors[i].y*ny + neighbors[i].x ] = true;
-                std::vector<Voxel> new_path = current;
-                new_path.push_back(neighbors[i]);
-                queue.push_back(new_path);
-            }
-        }
-    }
-    if (queue.empty()) {
+    VoxelSearch search(voxel_list, 1);
+    std::vector<Voxel> shortest_path = search.shortestPath(start, [&](const Voxel & voxel, unsigned int index) {
+        return voxel != start && goals.contains(voxel);
+    });
+    if (shortest_path.empty()) {
         std::cout << "\n\n\t\tFAILED FINDING PATH (3)\n\t\tFAILED FINDING PATH (3)\n\t\tFAILED FINDING PATH (3)\n\n" << std::endl;
     }
     return shortest_path;
@@ -1696,7 +1648,7 @@ std::vector<Voxel> shortestPathThree(CompFab::VoxelGrid * voxel_list, Voxel star
     @param normal The direction the piece is being removed in.
     @return Updates the piece if it's not connected, otherwise leave it alone.
 */
-std::vector<Voxel> ensurePieceConnectivity(CompFab::VoxelGrid * voxel_list, std::vector<Voxel> piece, Voxel normal) {
+Piece ensurePieceConnectivity(CompFab::VoxelGrid * voxel_list, Piece piece, Voxel normal) {
     if (debug) {
         std::cout << "in ensurePieceConnectivity" << std::endl;
         std::cout << "piece is: " << std::endl;
@@ -1711,38 +1663,30 @@ std::vector<Voxel> ensurePieceConnectivity(CompFab::VoxelGrid * voxel_list, std:
     int nz = voxel_list->m_dimZ;
     int size = nx*ny*nz;
 
-    bool *visited = new bool[size];
-    bool *inPiece = new bool[size];
+    ScratchLease visited(size);
     bool connected = false;
 
-    std::list<Voxel> newQueue;
+    IndexQueue & newQueue = visited->m_queue;
     Voxel start = piece[0];
     Voxel current;
-    bool in;
     Voxel end;
     std::vector<Voxel> path;
-    std::vector<Voxel> neighbors;
+    std::vector<Voxel> column;
+    Neighbors neighbors;
     std::vector<Voxel> disconnected;
     //while (!connected) {
-        for(unsigned int i=0; i<size; ++i) {
-            visited[i] = false;
-            inPiece[i] = false;
-        }
-        for (int i = 0; i < piece.size(); i++) {
-            inPiece[piece[i].z*(ny*nx) + piece[i].y*ny + piece[i].x] = true;
-        }
         newQueue.clear();
         
         //Mark the current node as visited and enqueue it
-        visited[start.z*(nx*ny) + start.y*ny + start.x] = true;
-        newQueue.push_back(start);
+        visited->mark(voxelIndex(voxel_list, start));
+        newQueue.push(voxelIndex(voxel_list, start));
         if (debug) {
             std::cout << "checking connection" << std::endl;
         }
         while ( !newQueue.empty() ) {
-            current = newQueue.front();
+            current = voxelAt(voxel_list, newQueue.front());
 
-            newQueue.pop_front();
+            newQueue.pop();
             neighbors = getNeighbors(current, voxel_list, 1);
             if (debug) {
                 std::cout << "current is " << current.toString() << ", it's neighbors are:" << std::endl;
@@ -1750,12 +1694,12 @@ std::vector<Voxel> ensurePieceConnectivity(CompFab::VoxelGrid * voxel_list, std:
             }
 
             for (int i = 0; i < neighbors.size(); i++) {
-                if ( !visited[ neighbors[i].z*(nx*ny) + neighbors[i].y*ny + neighbors[i].x ] && inPiece[neighbors[i].z*(ny*nx) + neighbors[i].y*ny + neighbors[i].x]  ) {
+                if ( !visited->marked(neighbors.index(i)) && piece.contains(neighbors[i])  ) {
                     if (debug) {
                         std::cout << "REACHED " << neighbors[i].toString() << " FROM " << current.toString() << std::endl;
                     }
-                    visited[ neighbors[i].z*(nx*ny) + neighbors[i].y*ny + neighbors[i].x ] = true;
-                    newQueue.push_back(neighbors[i]);
+                    visited->mark(neighbors.index(i));
+                    newQueue.push(neighbors.index(i));
                 }
             }
         }
@@ -1765,7 +1709,7 @@ std::vector<Voxel> ensurePieceConnectivity(CompFab::VoxelGrid * voxel_list, std:
         // okay so now make sure that all pieces have been visited
         disconnected.clear();
         for (int i = 0; i < piece.size(); i++) {
-            if (!visited[piece[i].z*(ny*nx) + piece[i].y*ny + piece[i].x]) {
+            if (!visited->marked(piece[i].z*(ny*nx) + piece[i].y*ny + piece[i].x)) {
                 disconnected.push_back(piece[i]);
             } else {
                 if (debug) {
@@ -1793,28 +1737,19 @@ std::vector<Voxel> ensurePieceConnectivity(CompFab::VoxelGrid * voxel_list, std:
                 printList(path);
             }
             for (int j = 0; j < path.size(); j++) {
-                end = path[j];
-                end += normal;
-                while (end.x < nx && end.x > -1 && end.y > -1 && end.y < ny && end.z > -1 && end.z < nz) {
-                    if ( voxel_list->isInside(end.x, end.y, end.z) == 1) {
-                        in = false;
-                        for (int k = 0; k < piece.size(); k++) {
-                            if (piece[k] == end) {
-                                in = true;
-                            }
+                column.clear();
+                collectAlongRay(voxel_list, path[j] + normal, normal, 1, &column);
+                for (int c = 0; c < column.size(); c++) {
+                    end = column[c];
+                    if (piece.insert(end)) {
+                        if (debug) {
+                            std::cout << "adding to piece " << end.toString() << std::endl;
                         }
-                        if (!in) {
-                            if (debug) {
-                                std::cout << "adding to piece " << end.toString() << std::endl;
-                            }
-                            piece.push_back(end);
-                        } else {
-                            if (debug) {
-                                std::cout << end.toString() << " is already in" << std::endl;
-                            }
+                    } else {
+                        if (debug) {
+                            std::cout << end.toString() << " is already in" << std::endl;
                         }
                     }
-                    end += normal;
                 }
             }   
         }
@@ -1833,7 +1768,7 @@ std::vector<Voxel> ensurePieceConnectivity(CompFab::VoxelGrid * voxel_list, std:
     @param pieceId The ID of the piece as it's set to in voxel_list
     @return true if the piece is connected, false otherwise.
 */
-bool checkPieceConnectivity(CompFab::VoxelGrid * voxel_list, std::vector<Voxel> piece, int pieceId) {
+bool checkPieceConnectivity(CompFab::VoxelGrid * voxel_list, const Piece & piece, int pieceId) {
     if (debug) {
         std::cout << "in checkPieceConnectivity" << std::endl;
     }
@@ -1843,12 +1778,8 @@ bool checkPieceConnectivity(CompFab::VoxelGrid * voxel_list, std::vector<Voxel>
     int nz = voxel_list->m_dimZ;
     int size = nx*ny*nz;
     
-    bool *visited = new bool[size];
-    for (int i = 0; i < size; i++) {
-        visited[i] = false;
-    }
-    std::list<Voxel> queue;
-    std::vector<Voxel> neighbors;
+    ScratchLease visited(size);
+    IndexQueue & queue = visited->m_queue;
     Voxel current;
     
     Voxel start = Voxel(-1,-1,-1);
@@ -1860,25 +1791,24 @@ bool checkPieceConnectivity(CompFab::VoxelGrid * voxel_list, std::vector<Voxel>
     }
     if (start == Voxel(-1,-1,-1)) {
         std::cout << "Error in checkPieceConnectivity" << std::endl;
+        return true;
     }
             
     //Mark the current node as visited and enqueue it 
-    visited[start.z*(nx*ny) + start.y*ny + start.x] = true;
-    queue.push_back(start);
+    visited->mark(voxelIndex(voxel_list, start));
+    queue.push(voxelIndex(voxel_list, start));
 
     while ( !queue.empty() ) {
-        current = queue.front();
-        queue.pop_front();
-        neighbors = getNeighbors(current, voxel_list, pieceId);
-        for (int i = 0; i < neighbors.size(); i++) {
-            if ( !visited[ neighbors[i].z*(nx*ny) + neighbors[i].y*ny + neighbors[i].x ] ) {
-                visited[ neighbors[i].z*(nx*ny) + neighbors[i].y*ny + neighbors[i].x ] = true;
-                queue.push_back(neighbors[i]);
+        current = voxelAt(voxel_list, queue.front());
+        queue.pop();
+        forEachNeighbor(voxel_list, current, pieceId, [&](const Voxel & next, unsigned int index) {
+            if (visited->testAndMark(index)) {
+                queue.push(index);
             }
-        }
+        });
     }
     for (int i = 0; i < piece.size(); i++) {
-        if (voxel_list->isInside(piece[i].x, piece[i].y, piece[i].z) == pieceId && !visited[piece[i].z*(ny*nx) + piece[i].y*ny + piece[i].x]) {
+        if (voxel_list->isInside(piece[i].x, piece[i].y, piece[i].z) == pieceId && !visited->marked(piece[i].z*(ny*nx) + piece[i].y*ny + piece[i].x)) {
             connected = false;
             break;
         }
@@ -1887,16 +1817,17 @@ bool checkPieceConnectivity(CompFab::VoxelGrid * voxel_list, std::vector<Voxel>
 }
 
 /**
-    Partitions a piece into 2 pieces.
+    Partitions a piece into 2 pieces. The articulation points of the rest of the piece are kept up
+    to date as the partition grows, so a voxel is only taken if the rest stays connected without it.
 
     @param voxel_list A VoxelGrid representing the current state of the puzzle.
     @param scores An AccessibilityStruct representing the current accesibility scores of the puzzle.
-    @param piece The piece being partitioned.
+    @param piece The piece being partitioned, i.e. every voxel labelled numPartition.
     @param numPartition The piece ID as set in voxel_list
     @param pieceSize The size of the partition
     @return The partitioned piece.
 */
-std::vector<Voxel> partitionPiece(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, std::vector<Voxel> piece, int numPartition, int pieceSize) {
+Piece partitionPiece(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, const Piece & piece, int numPartition, int pieceSize) {
     //if (debug) {
         std::cout << "in partitionPiece" << std::endl;
         std::cout << "piece size is " << std::to_string(pieceSize) << std::endl;
@@ -1912,55 +1843,65 @@ std::vector<Voxel> partitionPiece(CompFab::VoxelGrid * voxel_list, Accessibility
         sorted.push_back(VoxelSort(piece[i], scores->score(piece[i].x, piece[i].y, piece[i].z)));
     }
     std::sort (sorted.begin(), sorted.end(), voxelSortSorter);
-    piece.clear();
+    Piece byAccess;
     for (int i = 0; i < sorted.size(); i++) {
-        piece.push_back(sorted[i].voxel);
+        byAccess.insert(sorted[i].voxel);
     }
-
-    bool *visited = new bool[size];
-    for (int i = 0; i < size; i++) {
-        visited[i] = false;
+    Piece partition;
+    if (byAccess.empty()) {
+        return partition;
     }
-    std::list<Voxel> queue;
-    std::vector<Voxel> neighbors;
+
+    // What is left of the piece, with its blocks and articulation points
+    BlockForest rest(voxel_list, byAccess, numPartition);
+
+    ScratchLease visited(size);
+    IndexQueue & queue = visited->m_queue;
+    Neighbors neighbors;
     Voxel current;
 
-    Voxel start = piece[0];
+    Voxel start = byAccess[0];
     //Mark the current node as visited and enqueue it
-    visited[start.z*(nx*ny) + start.y*ny + start.x] = true;
-    queue.push_back(start);
+    visited->mark(voxelIndex(voxel_list, start));
+    queue.push(voxelIndex(voxel_list, start));
 
-    std::vector<Voxel> partition;
-    std::vector<Voxel> temp;
     while ( !queue.empty() ) {
         std::cout << "partition size is " <<  std::to_string(partition.size()) << std::endl;
-        current = queue.front();
+        current = voxelAt(voxel_list, queue.front());
         if (partition.size() >= pieceSize ) {
             break;
         }
 
-        queue.pop_front();
+        queue.pop();
         neighbors = getNeighbors(current, voxel_list, numPartition);
         for (int i = 0; i < neighbors.size(); i++) {
-            if ( !visited[ neighbors[i].z*(nx*ny) + neighbors[i].y*ny + neighbors[i].x ] ) {
+            if ( !visited->marked(neighbors.index(i)) ) {
                 // Ensure adding piece doesn't disconnect the partitions
-                temp = partition;
-                temp.push_back(neighbors[i]);
-                for (int j = 0; j< temp.size(); j++) {
-                    voxel_list->isInside(temp[j].x, temp[j].y, temp[j].z) = 0;
-                }
-                if (checkPieceConnectivity(voxel_list, piece, numPartition)) {
-                    partition = temp;
-                }
-                for (int j = 0; j< temp.size(); j++) {
-                    voxel_list->isInside(temp[j].x, temp[j].y, temp[j].z) = numPartition;
+                unsigned int id = rest.id(neighbors[i]);
+                if (id == BLOCK_FOREST_NONE) {
+                    // Not part of the piece, so only a search can tell
+                    partition.insert(neighbors[i]);
+                    GridTransaction trial(voxel_list);
+                    for (int j = 0; j< partition.size(); j++) {
+                        trial.relabel(partition[j], 0);
+                    }
+                    bool connected = checkPieceConnectivity(voxel_list, byAccess, numPartition);
+                    trial.rollback();
+                    if (!connected) {
+                        partition.erase(neighbors[i]);
+                    }
+                } else if (rest.m_size == 1 || rest.keepsConnected(id)) {
+                    if (rest.m_size == 1) {
+                        std::cout << "Error in checkPieceConnectivity" << std::endl;
+                    }
+                    partition.insert(neighbors[i]);
+                    rest.remove(id);
                 }
-                visited[ neighbors[i].z*(nx*ny) + neighbors[i].y*ny + neighbors[i].x ] = true;
+                visited->mark(neighbors.index(i));
 
-                queue.push_back(neighbors[i]);
+                queue.push(neighbors.index(i));
             }
         }
     }
-    delete[] visited;
     return partition;   
 }
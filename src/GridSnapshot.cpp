@@ -0,0 +1,168 @@
+/**
+    CS591-W1 Final Project
+    GridSnapshot.cpp
+    Purpose: For saving and mapping voxelized puzzles so several processes can share one copy.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../include/GridSnapshot.h"
+
+static_assert(sizeof(GridSnapshotHeader) == 128, "GridSnapshotHeader must stay 128 bytes");
+
+/**
+    Rounds an offset up to the next multiple of 8.
+
+    @param offset The offset to align.
+    @return The aligned offset.
+*/
+static uint64_t alignOffset(uint64_t offset) {
+    return (offset + 7) & ~((uint64_t)7);
+}
+
+/**
+    Constructor for the GridSnapshotStruct class. Wraps an already mapped snapshot.
+
+    @param base The start of the mapping.
+    @param length The length of the mapping in bytes.
+*/
+GridSnapshotStruct::GridSnapshotStruct(void *base, size_t length) {
+    m_base = base;
+    m_length = length;
+    m_header = (const GridSnapshotHeader *)base;
+
+    char *bytes = (char *)base;
+    CompFab::Vec3 lowerLeft(m_header->m_lowerLeft[0], m_header->m_lowerLeft[1], m_header->m_lowerLeft[2]);
+    m_grid = new CompFab::VoxelGrid(lowerLeft, m_header->m_dimX, m_header->m_dimY, m_header->m_dimZ,
+                                    m_header->m_spacing, (unsigned int *)(bytes + m_header->m_labelOffset));
+    m_scores = NULL;
+    if (m_header->m_flags & GRID_SNAPSHOT_HAS_SCORES) {
+        m_scores = new AccessibilityGrid(CompFab::Vec3(0.0, 0.0, 0.0), m_header->m_dimX, m_header->m_dimY, m_header->m_dimZ,
+                                         (double *)(bytes + m_header->m_scoreOffset));
+    }
+}
+
+/**
+    Destructor for the GridSnapshotStruct class. Local edits are discarded with the mapping.
+*/
+GridSnapshotStruct::~GridSnapshotStruct() {
+    delete m_grid;
+    delete m_scores;
+    munmap(m_base, m_length);
+}
+
+/**
+    Checks whether a file starts with a grid snapshot header.
+
+    @param filename The file to check.
+    @return true if the file is a snapshot, false otherwise.
+*/
+bool isGridSnapshot(const char * filename) {
+    std::ifstream in(filename, std::ios::binary);
+    char magic[8];
+    if (!in.read(magic, sizeof(magic))) {
+        return false;
+    }
+    return std::memcmp(magic, GRID_SNAPSHOT_MAGIC, sizeof(magic)) == 0;
+}
+
+/**
+    Writes a VoxelGrid and, optionally, its accessibility scores as a snapshot.
+
+    @param filename The filename to write.
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param scores The accessibility scores of voxel_list, or NULL to store labels only.
+    @return 1 if success, 0 otherwise.
+*/
+int saveGridSnapshot(std::string filename, CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores) {
+    std::ofstream out(filename.c_str(), std::ios::binary | std::ios::trunc);
+    if (!out.good()) {
+        std::cout << "cannot open snapshot " << filename << std::endl;
+        return 0;
+    }
+
+    GridSnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.m_magic, GRID_SNAPSHOT_MAGIC, sizeof(header.m_magic));
+    header.m_version = GRID_SNAPSHOT_VERSION;
+    header.m_headerSize = sizeof(GridSnapshotHeader);
+    header.m_dimX = voxel_list->m_dimX;
+    header.m_dimY = voxel_list->m_dimY;
+    header.m_dimZ = voxel_list->m_dimZ;
+    header.m_spacing = voxel_list->m_spacing;
+    for (int i = 0; i < 3; i++) {
+        header.m_lowerLeft[i] = voxel_list->m_lowerLeft[i];
+    }
+    header.m_labelOffset = sizeof(GridSnapshotHeader);
+    if (scores != NULL) {
+        header.m_flags |= GRID_SNAPSHOT_HAS_SCORES;
+        header.m_scoreOffset = alignOffset(header.m_labelOffset + (uint64_t)voxel_list->m_size*sizeof(unsigned int));
+    }
+
+    out.write((const char *)&header, sizeof(header));
+    out.write((const char *)voxel_list->m_insideArray, (std::streamsize)voxel_list->m_size*sizeof(unsigned int));
+    if (scores != NULL) {
+        std::vector<char> padding(header.m_scoreOffset - header.m_labelOffset - voxel_list->m_size*sizeof(unsigned int), 0);
+        out.write(padding.data(), padding.size());
+        out.write((const char *)scores->m_scoreArray, (std::streamsize)scores->m_size*sizeof(double));
+    }
+    if (!out.good()) {
+        std::cout << "failed writing snapshot " << filename << std::endl;
+        return 0;
+    }
+    return 1;
+}
+
+/**
+    Maps a snapshot written by saveGridSnapshot. The file is mapped once and privately, so any number of
+    processes share its pages until one of them edits a voxel or score.
+
+    @param filename The snapshot to map.
+    @return The mapped snapshot, or NULL if the file is missing or malformed.
+*/
+GridSnapshot * mapGridSnapshot(const char * filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        std::cout << "cannot open snapshot " << filename << std::endl;
+        return NULL;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(GridSnapshotHeader)) {
+        std::cout << "snapshot " << filename << " is too small" << std::endl;
+        close(fd);
+        return NULL;
+    }
+    size_t length = (size_t)info.st_size;
+    void *base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        std::cout << "cannot map snapshot " << filename << std::endl;
+        return NULL;
+    }
+
+    const GridSnapshotHeader *header = (const GridSnapshotHeader *)base;
+    uint64_t size = (uint64_t)header->m_dimX*header->m_dimY*header->m_dimZ;
+    bool valid = std::memcmp(header->m_magic, GRID_SNAPSHOT_MAGIC, sizeof(header->m_magic)) == 0
+                 && header->m_version == GRID_SNAPSHOT_VERSION
+                 && header->m_headerSize == sizeof(GridSnapshotHeader)
+                 && header->m_labelOffset % 8 == 0
+                 && header->m_labelOffset + size*sizeof(unsigned int) <= length;
+    if (valid && (header->m_flags & GRID_SNAPSHOT_HAS_SCORES)) {
+        valid = header->m_scoreOffset % 8 == 0 && header->m_scoreOffset + size*sizeof(double) <= length;
+    }
+    if (!valid) {
+        std::cout << "snapshot " << filename << " is not a version " << GRID_SNAPSHOT_VERSION << " grid snapshot" << std::endl;
+        munmap(base, length);
+        return NULL;
+    }
+    return new GridSnapshot(base, length);
+}
@@ -0,0 +1,110 @@
+/**
+    CS591-W1 Final Project
+    GridTransaction.cpp
+    Purpose: For trial edits to the voxel grid that can be tested and undone.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#include <vector>
+#include "../include/GridTransaction.h"
+#include "../include/RemainderOracle.h"
+#include "../include/Direction.h"
+
+/**
+    Records the remainder oracle's state, if it covers this grid, as the point to roll back to.
+*/
+static void saveOracle(GridTransaction * transaction) {
+    if (g_remainderOracle != NULL && g_remainderOracle->m_grid == transaction->m_grid) {
+        transaction->m_oracleKnown = g_remainderOracle->m_known;
+        transaction->m_oracleConnected = g_remainderOracle->m_connected;
+        transaction->m_oracleRemoved = g_remainderOracle->m_removed;
+    }
+}
+
+/**
+    Constructor for the GridTransactionStruct class. Begins a transaction with no changes.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+*/
+GridTransactionStruct::GridTransactionStruct(CompFab::VoxelGrid * voxel_list) : m_sets(voxel_list->m_size) {
+    m_grid = voxel_list;
+    m_oracleKnown = false;
+    m_oracleConnected = false;
+    saveOracle(this);
+}
+
+/**
+    Sets the label of a voxel, remembering the old one.
+
+    @param voxel The voxel being relabelled.
+    @param label The new label.
+*/
+void GridTransactionStruct::relabel(const Voxel & voxel, unsigned int label) {
+    m_labels.push_back(std::make_pair(voxel, m_grid->isInside(voxel.x, voxel.y, voxel.z)));
+    setVoxelLabel(m_grid, voxel, label);
+}
+
+/**
+    Adds a voxel to the tracked set, joining it to the face neighbors already in it.
+
+    @param voxel The voxel. Including one twice has no effect.
+*/
+void GridTransactionStruct::include(const Voxel & voxel) {
+    unsigned int index = voxelIndex(m_grid, voxel);
+    if (m_sets.contains(index)) {
+        return;
+    }
+    m_sets.add(index);
+    for (int d = 0; d < 6; d++) {
+        Voxel next = voxel + directionVoxel((Direction)d);
+        if (next.x < 0 || next.x >= (int)m_grid->m_dimX || next.y < 0 || next.y >= (int)m_grid->m_dimY
+            || next.z < 0 || next.z >= (int)m_grid->m_dimZ) {
+            continue;
+        }
+        unsigned int nextIndex = voxelIndex(m_grid, next);
+        if (m_sets.contains(nextIndex)) {
+            m_sets.unite(index, nextIndex);
+        }
+    }
+}
+
+/**
+    Checks whether two included voxels are joined through included voxels.
+
+    @param a An included voxel.
+    @param b Another included voxel.
+    @return true if they are connected, false otherwise.
+*/
+bool GridTransactionStruct::connected(const Voxel & a, const Voxel & b) const {
+    return m_sets.find(voxelIndex(m_grid, a)) == m_sets.find(voxelIndex(m_grid, b));
+}
+
+/**
+    Undoes every change since the transaction began or was last committed, latest first.
+*/
+void GridTransactionStruct::rollback() {
+    m_sets.rollback(0);
+    if (m_labels.empty()) {
+        return;
+    }
+    for (size_t i = m_labels.size(); i-- > 0; ) {
+        setVoxelLabel(m_grid, m_labels[i].first, m_labels[i].second);
+    }
+    m_labels.clear();
+    // The remainder is what it was, so what the oracle knew about it holds again
+    if (g_remainderOracle != NULL && g_remainderOracle->m_grid == m_grid) {
+        g_remainderOracle->m_known = m_oracleKnown;
+        g_remainderOracle->m_connected = m_oracleConnected;
+        g_remainderOracle->m_removed = m_oracleRemoved;
+    }
+}
+
+/**
+    Keeps every change so far, making this the point later rollbacks return to.
+*/
+void GridTransactionStruct::commit() {
+    m_labels.clear();
+    m_sets.commit();
+    saveOracle(this);
+}
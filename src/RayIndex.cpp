@@ -0,0 +1,212 @@
+/**
+    CS591-W1 Final Project
+    RayIndex.cpp
+    Purpose: For answering axis-aligned ray queries over the voxels of one label.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#include <vector>
+#include "../include/RayIndex.h"
+
+/**
+    Finds the first set bit at or after position from.
+
+    @param words The bitset.
+    @param n The number of bits in the bitset.
+    @param from The first position to consider.
+    @return The position of the bit, or -1 if there is none.
+*/
+static int nextSet(const uint64_t * words, int n, int from) {
+    if (from >= n) {
+        return -1;
+    }
+    int w = from >> 6;
+    uint64_t bits = words[w] & (~(uint64_t)0 << (from & 63));
+    int last = (n - 1) >> 6;
+    while (true) {
+        if (bits) {
+            int pos = (w << 6) + __builtin_ctzll(bits);
+            return pos < n ? pos : -1;
+        }
+        if (++w > last) {
+            return -1;
+        }
+        bits = words[w];
+    }
+}
+
+/**
+    Finds the last set bit at or before position from.
+
+    @param words The bitset.
+    @param from The last position to consider.
+    @return The position of the bit, or -1 if there is none.
+*/
+static int prevSet(const uint64_t * words, int from) {
+    if (from < 0) {
+        return -1;
+    }
+    int w = from >> 6;
+    int shift = 63 - (from & 63);
+    uint64_t bits = (words[w] << shift) >> shift;
+    while (true) {
+        if (bits) {
+            return (w << 6) + 63 - __builtin_clzll(bits);
+        }
+        if (--w < 0) {
+            return -1;
+        }
+        bits = words[w];
+    }
+}
+
+/**
+    Counts the set bits in the inclusive range [lo, hi].
+
+    @param words The bitset.
+    @param lo The first position to count.
+    @param hi The last position to count.
+    @return The number of set bits.
+*/
+static int countRange(const uint64_t * words, int lo, int hi) {
+    if (lo > hi) {
+        return 0;
+    }
+    int wlo = lo >> 6;
+    int whi = hi >> 6;
+    uint64_t lowMask = ~(uint64_t)0 << (lo & 63);
+    uint64_t highMask = ~(uint64_t)0 >> (63 - (hi & 63));
+    if (wlo == whi) {
+        return __builtin_popcountll(words[wlo] & lowMask & highMask);
+    }
+    int total = __builtin_popcountll(words[wlo] & lowMask);
+    for (int w = wlo + 1; w < whi; w++) {
+        total += __builtin_popcountll(words[w]);
+    }
+    return total + __builtin_popcountll(words[whi] & highMask);
+}
+
+/**
+    Constructor for the RayIndexStruct class. Scans the grid once.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param label The label whose voxels are indexed. Usually is 1.
+*/
+RayIndexStruct::RayIndexStruct(CompFab::VoxelGrid * voxel_list, unsigned int label) {
+    m_grid = voxel_list;
+    m_label = label;
+    m_dim[0] = voxel_list->m_dimX;
+    m_dim[1] = voxel_list->m_dimY;
+    m_dim[2] = voxel_list->m_dimZ;
+    for (int axis = 0; axis < 3; axis++) {
+        m_words[axis] = (m_dim[axis] + 63) / 64;
+        size_t lines = (size_t)m_dim[(axis + 1) % 3]*m_dim[(axis + 2) % 3];
+        m_lines[axis].assign(lines*m_words[axis], 0);
+    }
+    for (int i = 0; i < m_dim[0]; i++) {
+        for (int j = 0; j < m_dim[1]; j++) {
+            for (int k = 0; k < m_dim[2]; k++) {
+                if (voxel_list->isInside(i, j, k) == label) {
+                    update(Voxel(i, j, k), true);
+                }
+            }
+        }
+    }
+}
+
+/**
+    Records that a voxel gained or lost the indexed label.
+
+    @param voxel The voxel that changed.
+    @param occupied true if the voxel now holds the indexed label.
+*/
+void RayIndexStruct::update(const Voxel & voxel, bool occupied) {
+    int coord[3] = {voxel.x, voxel.y, voxel.z};
+    for (int axis = 0; axis < 3; axis++) {
+        uint64_t *words = &m_lines[axis][lineOffset(axis, voxel)];
+        uint64_t bit = (uint64_t)1 << (coord[axis] & 63);
+        if (occupied) {
+            words[coord[axis] >> 6] |= bit;
+        } else {
+            words[coord[axis] >> 6] &= ~bit;
+        }
+    }
+}
+
+/**
+    Checks whether a voxel holds the indexed label.
+
+    @param voxel The voxel to check.
+    @return true if it does, false otherwise.
+*/
+bool RayIndexStruct::occupied(const Voxel & voxel) const {
+    const uint64_t *words = &m_lines[0][lineOffset(0, voxel)];
+    return (words[voxel.x >> 6] >> (voxel.x & 63)) & 1;
+}
+
+/**
+    Finds the closest indexed voxel on the ray starting at from (inclusive) and stepping by dir.
+
+    @param from The first voxel of the ray. Must be inside the grid.
+    @param dir The direction of the ray.
+    @return The voxel, or (-1, -1, -1) if the ray holds none.
+*/
+Voxel RayIndexStruct::nearest(const Voxel & from, Direction dir) const {
+    int axis = directionAxis(dir);
+    int coord[3] = {from.x, from.y, from.z};
+    const uint64_t *words = &m_lines[axis][lineOffset(axis, from)];
+    int pos = directionSign(dir) > 0 ? nextSet(words, m_dim[axis], coord[axis]) : prevSet(words, coord[axis]);
+    if (pos < 0) {
+        return Voxel(-1, -1, -1);
+    }
+    coord[axis] = pos;
+    return Voxel(coord[0], coord[1], coord[2]);
+}
+
+/**
+    Finds the furthest indexed voxel on the ray starting at from (inclusive) and stepping by dir.
+
+    @param from The first voxel of the ray. Must be inside the grid.
+    @param dir The direction of the ray.
+    @return The voxel, or (-1, -1, -1) if the ray holds none.
+*/
+Voxel RayIndexStruct::farthest(const Voxel & from, Direction dir) const {
+    int axis = directionAxis(dir);
+    int coord[3] = {from.x, from.y, from.z};
+    const uint64_t *words = &m_lines[axis][lineOffset(axis, from)];
+    int pos;
+    if (directionSign(dir) > 0) {
+        pos = prevSet(words, m_dim[axis] - 1);
+        if (pos < coord[axis]) {
+            pos = -1;
+        }
+    } else {
+        pos = nextSet(words, m_dim[axis], 0);
+        if (pos > coord[axis]) {
+            pos = -1;
+        }
+    }
+    if (pos < 0) {
+        return Voxel(-1, -1, -1);
+    }
+    coord[axis] = pos;
+    return Voxel(coord[0], coord[1], coord[2]);
+}
+
+/**
+    Counts the indexed voxels on the ray starting at from (inclusive) and stepping by dir.
+
+    @param from The first voxel of the ray. Must be inside the grid.
+    @param dir The direction of the ray.
+    @return The number of indexed voxels on the ray.
+*/
+int RayIndexStruct::count(const Voxel & from, Direction dir) const {
+    int axis = directionAxis(dir);
+    int coord[3] = {from.x, from.y, from.z};
+    const uint64_t *words = &m_lines[axis][lineOffset(axis, from)];
+    if (directionSign(dir) > 0) {
+        return countRange(words, coord[axis], m_dim[axis] - 1);
+    }
+    return countRange(words, 0, coord[axis]);
+}
@@ -0,0 +1,208 @@
+/**
+    CS591-W1 Final Project
+    RemainderOracle.cpp
+    Purpose: For answering whether taking voxels out of the unassigned remainder disconnects it.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#include <vector>
+#include "../include/RemainderOracle.h"
+#include "../include/ScratchGrid.h"
+
+//Region value of a voxel taken out of the remainder
+#define REMAINDER_REMOVED 0xFFFFFFFFu
+
+/**
+    Constructor for the RemainderOracleStruct class. Loads the unassigned voxels of the grid.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+*/
+RemainderOracleStruct::RemainderOracleStruct(CompFab::VoxelGrid * voxel_list) : m_unassigned(voxel_list->m_dimX, voxel_list->m_dimY, voxel_list->m_dimZ) {
+    m_grid = voxel_list;
+    loadLabel(voxel_list, 1, &m_unassigned);
+    m_count = 0;
+    for (unsigned int i = 0; i < voxel_list->m_size; i++) {
+        m_count += voxel_list->m_insideArray[i] == 1;
+    }
+    m_known = false;
+    m_connected = false;
+    m_localChecks = 0;
+    m_fullChecks = 0;
+}
+
+/**
+    Records a voxel joining or leaving the remainder.
+
+    @param voxel The voxel whose label changed.
+    @param unassigned true if it is now unassigned, false if it was just assigned.
+*/
+void RemainderOracleStruct::update(const Voxel & voxel, bool unassigned) {
+    if (unassigned) {
+        m_unassigned.set(voxel);
+        m_count++;
+        m_known = false;
+        m_removed.clear();
+        return;
+    }
+    m_unassigned.reset(voxel);
+    m_count--;
+    if (m_known) {
+        m_removed.push_back(voxel);
+    }
+}
+
+static inline unsigned int findRegion(std::vector<unsigned int> & parent, unsigned int region) {
+    while (parent[region] != region) {
+        parent[region] = parent[parent[region]];
+        region = parent[region];
+    }
+    return region;
+}
+
+/**
+    Decides from the neighborhood of a set of voxels whether the rest of a connected region stays
+    connected without them. The unassigned voxels of the grid, less the set, are what is left.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param cells The voxels taken out. Their union with the unassigned voxels must be connected.
+    @return 1 if what is left is connected or empty, 0 if it isn't, -1 if the search ran past its
+            budget without deciding.
+*/
+static int localCheck(CompFab::VoxelGrid * voxel_list, const std::vector<Voxel> & cells) {
+    ScratchLease visited(voxel_list->m_size);
+    visited->reserveValues();
+    for (int i = 0; i < cells.size(); i++) {
+        unsigned int index = voxelIndex(voxel_list, cells[i]);
+        visited->mark(index);
+        visited->value(index) = REMAINDER_REMOVED;
+    }
+
+    // Every unassigned voxel bordering the set starts a region of its own
+    IndexQueue & queue = visited->m_queue;
+    std::vector<unsigned int> parent;
+    std::vector<unsigned int> frontier;
+    for (int i = 0; i < cells.size(); i++) {
+        forEachNeighbor(voxel_list, cells[i], 1, [&](const Voxel & next, unsigned int index) {
+            if (visited->testAndMark(index)) {
+                visited->value(index) = parent.size();
+                parent.push_back(parent.size());
+                frontier.push_back(1);
+                queue.push(index);
+            }
+        });
+    }
+    unsigned int regions = parent.size();
+    if (regions == 0) {
+        return 1;
+    }
+
+    unsigned long long budget = 32*(unsigned long long)regions + 1024;
+    while (regions > 1) {
+        if (budget-- == 0) {
+            return -1;
+        }
+        unsigned int index = queue.front();
+        queue.pop();
+        unsigned int region = findRegion(parent, visited->value(index));
+        frontier[region]--;
+        forEachNeighbor(voxel_list, voxelAt(voxel_list, index), 1, [&](const Voxel & next, unsigned int nextIndex) {
+            if (visited->testAndMark(nextIndex)) {
+                visited->value(nextIndex) = region;
+                frontier[region]++;
+                queue.push(nextIndex);
+                return;
+            }
+            unsigned int other = visited->value(nextIndex);
+            if (other == REMAINDER_REMOVED) {
+                return;
+            }
+            other = findRegion(parent, other);
+            if (other != region) {
+                parent[other] = region;
+                frontier[region] += frontier[other];
+                regions--;
+            }
+        });
+        if (frontier[region] == 0 && regions > 1) {
+            // Nothing left to grow into, so this region is cut off from the others
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+    Floods the remainder less a set of voxels.
+
+    @param oracle The oracle.
+    @param cells The voxels taken out.
+    @return true if what is left is connected or empty, false otherwise.
+*/
+static bool fullCheck(RemainderOracle * oracle, const std::vector<Voxel> & cells) {
+    oracle->m_fullChecks++;
+    BitVolume remainder = oracle->m_unassigned;
+    for (int i = 0; i < cells.size(); i++) {
+        remainder.reset(cells[i]);
+    }
+    if (!remainder.any()) {
+        return true;
+    }
+    BitVolume reach(remainder.m_dimX, remainder.m_dimY, remainder.m_dimZ);
+    reach.set(remainder.first());
+    floodFill(remainder, &reach);
+    return reach.covers(remainder);
+}
+
+/**
+    Checks whether the unassigned voxels are connected, first bringing the answer up to date with
+    any voxels assigned since the last query.
+
+    @return true if they are connected or there are none, false otherwise.
+*/
+bool RemainderOracleStruct::connected() {
+    if (m_known && !m_removed.empty()) {
+        int verdict = m_connected ? localCheck(m_grid, m_removed) : -1;
+        m_removed.clear();
+        if (verdict == -1) {
+            m_known = false;
+        } else {
+            m_connected = verdict == 1;
+        }
+    }
+    if (!m_known) {
+        m_connected = fullCheck(this, std::vector<Voxel>());
+        m_known = true;
+        m_removed.clear();
+    }
+    return m_connected;
+}
+
+/**
+    Checks whether the unassigned voxels would still be connected without a piece's voxels.
+
+    @param piece The piece. Voxels of it that are not unassigned are ignored.
+    @return true if what is left would be connected or empty, false otherwise.
+*/
+bool RemainderOracleStruct::staysConnected(const Piece & piece) {
+    std::vector<Voxel> cells;
+    for (int i = 0; i < piece.size(); i++) {
+        if (m_unassigned.test(piece[i])) {
+            cells.push_back(piece[i]);
+        }
+    }
+    if (cells.size() == m_count) {
+        return true;
+    }
+    if (connected()) {
+        if (cells.empty()) {
+            return true;
+        }
+        int verdict = localCheck(m_grid, cells);
+        if (verdict != -1) {
+            m_localChecks++;
+            return verdict == 1;
+        }
+    }
+    return fullCheck(this, cells);
+}
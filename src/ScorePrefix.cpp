@@ -0,0 +1,86 @@
+/**
+    CS591-W1 Final Project
+    ScorePrefix.cpp
+    Purpose: For summing accessibility scores along axis-aligned runs in constant time.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#include <vector>
+#include <algorithm>
+#include "../include/ScorePrefix.h"
+
+/**
+    Constructor for the ScorePrefixStruct class. Every line starts out dirty.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param scores The scores to sum. Must outlive the sums.
+    @param label The label of the voxels whose scores count.
+*/
+ScorePrefixStruct::ScorePrefixStruct(CompFab::VoxelGrid * voxel_list, AccessibilityGrid * scores, unsigned int label) {
+    m_grid = voxel_list;
+    m_scores = scores;
+    m_label = label;
+    m_dim[0] = voxel_list->m_dimX;
+    m_dim[1] = voxel_list->m_dimY;
+    m_dim[2] = voxel_list->m_dimZ;
+    m_rebuilt = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        size_t lines = (size_t)m_dim[(axis + 1) % 3]*m_dim[(axis + 2) % 3];
+        m_sums[axis].assign(lines*(m_dim[axis] + 1), 0.0);
+        m_dirty[axis].assign(lines, 1);
+    }
+}
+
+/**
+    Marks the three lines through a voxel whose label or score changed.
+
+    @param voxel The voxel.
+*/
+void ScorePrefixStruct::touch(const Voxel & voxel) {
+    for (int axis = 0; axis < 3; axis++) {
+        m_dirty[axis][line(axis, voxel)] = 1;
+    }
+}
+
+/**
+    Marks every line, for when the scores were replaced wholesale.
+*/
+void ScorePrefixStruct::touchAll() {
+    for (int axis = 0; axis < 3; axis++) {
+        std::fill(m_dirty[axis].begin(), m_dirty[axis].end(), 1);
+    }
+}
+
+/**
+    Sums the scores of the voxels holding the label on the ray starting at from (inclusive) and
+    stepping in a direction, i.e. the voxels collectAlongRay would return.
+
+    @param from The first voxel of the ray.
+    @param dir The direction of the ray.
+    @return The sum.
+*/
+double ScorePrefixStruct::runSum(const Voxel & from, Direction dir) {
+    const int axis = directionAxis(dir);
+    const unsigned int length = m_dim[axis];
+    const unsigned int l = line(axis, from);
+    double *sums = &m_sums[axis][(size_t)l*(length + 1)];
+    if (m_dirty[axis][l]) {
+        const unsigned int *labels = m_grid->m_insideArray;
+        const double *scores = m_scores->m_scoreArray;
+        Voxel voxel = from;
+        int *coord = axis == 0 ? &voxel.x : axis == 1 ? &voxel.y : &voxel.z;
+        for (unsigned int t = 0; t < length; t++) {
+            *coord = t;
+            unsigned int index = voxelIndex(m_grid, voxel);
+            sums[t + 1] = labels[index] == m_label ? sums[t] + scores[index] : sums[t];
+        }
+        m_dirty[axis][l] = 0;
+        m_rebuilt++;
+    }
+    int t = axis == 0 ? from.x : axis == 1 ? from.y : from.z;
+    if (directionSign(dir) > 0) {
+        return sums[length] - sums[t];
+    }
+    return sums[t + 1];
+}
@@ -0,0 +1,92 @@
+/**
+    CS591-W1 Final Project
+    ScratchGrid.cpp
+    Purpose: For reusable per-thread visited marks over the voxel grid.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#include <vector>
+#include <algorithm>
+#include "../include/ScratchGrid.h"
+
+/**
+    Constructor for the ScratchGridStruct class. Starts empty; reset sizes it.
+*/
+ScratchGridStruct::ScratchGridStruct() {
+    m_epoch = 1;
+}
+
+/**
+    Clears every mark and makes sure at least size cells are available.
+
+    @param size The number of cells needed, usually the size of the voxel grid.
+*/
+void ScratchGridStruct::reset(unsigned int size) {
+    m_queue.clear();
+    if (m_stamp.size() < size) {
+        m_stamp.assign(size, 0);
+        m_epoch = 1;
+        return;
+    }
+    m_epoch++;
+    if (m_epoch == 0) {
+        std::fill(m_stamp.begin(), m_stamp.end(), 0);
+        m_epoch = 1;
+    }
+}
+
+/**
+    Makes sure every cell has a value slot. Values are never cleared, so they must be written when
+    a cell is marked before they are read.
+*/
+void ScratchGridStruct::reserveValues() {
+    if (m_value.size() < m_stamp.size()) {
+        m_value.resize(m_stamp.size());
+    }
+}
+
+/**
+    Doubles the capacity of the ring, moving the queued indices to its start in order.
+*/
+void IndexQueueStruct::grow() {
+    std::vector<uint32_t> ring(std::max<size_t>(64, 2*m_ring.size()));
+    for (unsigned int i = 0; i < m_count; i++) {
+        ring[i] = m_ring[(m_head + i) & (m_ring.size() - 1)];
+    }
+    m_ring.swap(ring);
+    m_head = 0;
+}
+
+/*
+    Grids not currently leased by this thread. They are never freed, so after the first few calls
+    a run allocates nothing here; the pool only grows as deep as the deepest nesting of leases.
+*/
+static thread_local std::vector<ScratchGrid *> t_pool;
+
+/**
+    Takes a cleared grid from the calling thread's pool, creating one if the pool is empty.
+
+    @param size The number of cells needed.
+    @return The grid, which must be handed back with releaseScratch.
+*/
+ScratchGrid * acquireScratch(unsigned int size) {
+    ScratchGrid *scratch;
+    if (t_pool.empty()) {
+        scratch = new ScratchGrid();
+    } else {
+        scratch = t_pool.back();
+        t_pool.pop_back();
+    }
+    scratch->reset(size);
+    return scratch;
+}
+
+/**
+    Returns a grid to the calling thread's pool.
+
+    @param scratch A grid from acquireScratch.
+*/
+void releaseScratch(ScratchGrid * scratch) {
+    t_pool.push_back(scratch);
+}
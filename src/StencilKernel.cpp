@@ -0,0 +1,189 @@
+/**
+    CS591-W1 Final Project
+    StencilKernel.cpp
+    Purpose: For the vectorized accessibility stencil, picked at run time.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#include <algorithm>
+#include "../include/StencilKernel.h"
+#include "../include/Direction.h"
+#include "../include/Parallel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STENCIL_X86 1
+#endif
+
+/**
+    Finds the widest kernel the processor running this supports.
+
+    @return The mode.
+*/
+StencilMode bestStencilMode() {
+#ifdef STENCIL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return STENCIL_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return STENCIL_SSE2;
+    }
+#endif
+    return STENCIL_SCALAR;
+}
+
+StencilMode g_stencilMode = bestStencilMode();
+
+/**
+    The name of a mode, for printing.
+*/
+const char * stencilModeName(StencilMode mode) {
+    static const char *names[STENCIL_MODE_COUNT] = { "scalar", "sse2", "avx2" };
+    return names[mode];
+}
+
+/*
+    Every kernel computes, for each cell i in [begin, end),
+
+        level[i] = (0 + below[i + s0] + below[i + s1] + ...) * multiplier + below[i]
+
+    over the neighbors present in neighbors[i], in Direction order. The vector kernels add every
+    neighbor and zero the missing ones with a lane mask instead; adding +0.0 to a sum of
+    non-negative scores leaves it unchanged, so all kernels produce the same bits. They load every
+    neighbor whether present or not, so they may only run over cells whose six neighbor indices
+    are all inside the grid, which holds for every cell off the first and last z planes.
+*/
+
+/**
+    Scores a range of cells one at a time.
+*/
+static void scalarRange(const int * strides, const uint8_t * neighbors, const double * below, double multiplier, double * level,
+                        unsigned int begin, unsigned int end) {
+    for (unsigned int i = begin; i < end; i++) {
+        double current_score = 0;
+        for (uint8_t mask = neighbors[i]; mask != 0; mask &= mask - 1) {
+            current_score += below[i + strides[__builtin_ctz(mask)]];
+        }
+        current_score *= multiplier;
+        current_score += below[i];
+        level[i] = current_score;
+    }
+}
+
+#ifdef STENCIL_X86
+/**
+    Scores a range of cells two at a time with SSE2. Each direction's lane mask is looked up from
+    the pair of neighbor bits.
+*/
+__attribute__((target("sse2")))
+static void sse2Range(const int * strides, const uint8_t * neighbors, const double * below, double multiplier, double * level,
+                      unsigned int begin, unsigned int end) {
+    const __m128d lanes[4] = { _mm_castsi128_pd(_mm_set_epi64x(0, 0)), _mm_castsi128_pd(_mm_set_epi64x(0, -1)),
+                               _mm_castsi128_pd(_mm_set_epi64x(-1, 0)), _mm_castsi128_pd(_mm_set_epi64x(-1, -1)) };
+    const __m128d scale = _mm_set1_pd(multiplier);
+    unsigned int i = begin;
+    for (; i + 2 <= end; i += 2) {
+        unsigned int pair = neighbors[i] | (neighbors[i + 1] << 8);
+        __m128d sum = _mm_setzero_pd();
+        for (int d = NEG_X; d < NO_DIRECTION; d++) {
+            unsigned int bits = ((pair >> d) & 1) | ((pair >> (d + 7)) & 2);
+            sum = _mm_add_pd(sum, _mm_and_pd(lanes[bits], _mm_loadu_pd(below + i + strides[d])));
+        }
+        sum = _mm_add_pd(_mm_mul_pd(sum, scale), _mm_loadu_pd(below + i));
+        _mm_storeu_pd(level + i, sum);
+    }
+    scalarRange(strides, neighbors, below, multiplier, level, i, end);
+}
+
+/**
+    Scores a range of cells four at a time with AVX2. The four neighbor masks are widened to one
+    64-bit lane each and compared against each direction's bit.
+*/
+__attribute__((target("avx2")))
+static void avx2Range(const int * strides, const uint8_t * neighbors, const double * below, double multiplier, double * level,
+                      unsigned int begin, unsigned int end) {
+    const __m256d scale = _mm256_set1_pd(multiplier);
+    const int s0 = strides[NEG_X], s1 = strides[POS_X], s2 = strides[NEG_Y];
+    const int s3 = strides[POS_Y], s4 = strides[NEG_Z], s5 = strides[POS_Z];
+    unsigned int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        int packed;
+        __builtin_memcpy(&packed, neighbors + i, sizeof(packed));
+        __m256i masks = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(packed));
+        #define STENCIL_TERM(d, s) \
+            _mm256_and_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(masks, _mm256_set1_epi64x(1 << d)), _mm256_set1_epi64x(1 << d))), \
+                          _mm256_loadu_pd(below + i + s))
+        __m256d sum = _mm256_setzero_pd();
+        sum = _mm256_add_pd(sum, STENCIL_TERM(NEG_X, s0));
+        sum = _mm256_add_pd(sum, STENCIL_TERM(POS_X, s1));
+        sum = _mm256_add_pd(sum, STENCIL_TERM(NEG_Y, s2));
+        sum = _mm256_add_pd(sum, STENCIL_TERM(POS_Y, s3));
+        sum = _mm256_add_pd(sum, STENCIL_TERM(NEG_Z, s4));
+        sum = _mm256_add_pd(sum, STENCIL_TERM(POS_Z, s5));
+        #undef STENCIL_TERM
+        sum = _mm256_add_pd(_mm256_mul_pd(sum, scale), _mm256_loadu_pd(below + i));
+        _mm256_storeu_pd(level + i, sum);
+    }
+    scalarRange(strides, neighbors, below, multiplier, level, i, end);
+}
+#endif
+
+/**
+    Computes one level of the accessibility recursion over a range of z slices with the kernel
+    chosen by g_stencilMode. The first and last z planes of the grid always take the scalar kernel.
+
+    @param strides The index offset of each Direction.
+    @param size The number of cells in the grid.
+    @param plane The number of cells in one z slice.
+    @param begin The first cell of the range, at the start of a slice.
+    @param end The cell after the range, at the start of a slice.
+*/
+static void stencilRange(const int * strides, unsigned int size, unsigned int plane, const uint8_t * neighbors, const double * below,
+                         double multiplier, double * level, unsigned int begin, unsigned int end) {
+    unsigned int vectorBegin = std::max(begin, plane);
+    unsigned int vectorEnd = std::min(end, size > plane ? size - plane : 0);
+    if (g_stencilMode == STENCIL_SCALAR || vectorBegin >= vectorEnd) {
+        scalarRange(strides, neighbors, below, multiplier, level, begin, end);
+        return;
+    }
+    scalarRange(strides, neighbors, below, multiplier, level, begin, vectorBegin);
+#ifdef STENCIL_X86
+    if (g_stencilMode == STENCIL_AVX2) {
+        avx2Range(strides, neighbors, below, multiplier, level, vectorBegin, vectorEnd);
+    } else {
+        sse2Range(strides, neighbors, below, multiplier, level, vectorBegin, vectorEnd);
+    }
+#else
+    scalarRange(strides, neighbors, below, multiplier, level, vectorBegin, vectorEnd);
+#endif
+    scalarRange(strides, neighbors, below, multiplier, level, vectorEnd, end);
+}
+
+/**
+    Computes one level of the accessibility recursion over the whole grid, split into z slabs that
+    run on their own threads. Each slab writes only its own cells and reads the level below,
+    neighbor planes of other slabs included, which no one writes during the level, so no halo
+    needs copying and the result doesn't depend on the number of threads. Returns once every slab
+    is done, so the next level can start.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param neighbors The neighbors of each cell holding the scored label, bit d set for Direction d.
+    @param below The scores of the level below.
+    @param multiplier alpha raised to this level.
+    @param level Where to write this level's scores. Must not overlap below.
+    @param threads The number of threads to use, or 0 to pick from the grid size.
+*/
+void stencilLevel(CompFab::VoxelGrid * voxel_list, const uint8_t * neighbors, const double * below, double multiplier, double * level,
+                  unsigned int threads) {
+    const int strides[6] = { directionStride<NEG_X>(voxel_list), directionStride<POS_X>(voxel_list),
+                             directionStride<NEG_Y>(voxel_list), directionStride<POS_Y>(voxel_list),
+                             directionStride<NEG_Z>(voxel_list), directionStride<POS_Z>(voxel_list) };
+    const unsigned int size = voxel_list->m_size;
+    const unsigned int plane = voxel_list->m_dimX*voxel_list->m_dimY;
+    const unsigned int slabs = slabCount(size, voxel_list->m_dimZ, threads);
+    parallelRanges(voxel_list->m_dimZ, slabs, [&](unsigned int slab, unsigned int zBegin, unsigned int zEnd) {
+        stencilRange(strides, size, plane, neighbors, below, multiplier, level, zBegin*plane, zEnd*plane);
+    });
+}
@@ -0,0 +1,89 @@
+/**
+    CS591-W1 Final Project
+    UnionFind.cpp
+    Purpose: For a disjoint-set forest over grid cells whose changes can be undone.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#include <vector>
+#include "../include/UnionFind.h"
+
+//Root value of the log entry for an added cell
+#define UNION_FIND_ADDED 0xFFFFFFFFu
+
+/**
+    Constructor for the RollbackUnionFindStruct class. Starts with no cells.
+
+    @param size The number of cells, usually the size of the voxel grid.
+*/
+RollbackUnionFindStruct::RollbackUnionFindStruct(unsigned int size) : m_parent(size), m_rank(size) {
+    m_parent->reserveValues();
+    m_rank->reserveValues();
+    m_components = 0;
+}
+
+/**
+    Adds a cell as a set of its own.
+
+    @param i The cell, which must not be in the structure yet.
+*/
+void RollbackUnionFindStruct::add(unsigned int i) {
+    m_parent->mark(i);
+    m_parent->value(i) = i;
+    m_rank->value(i) = 0;
+    m_components++;
+    Change change = {i, UNION_FIND_ADDED, false};
+    m_log.push_back(change);
+}
+
+/**
+    Merges the sets of two cells, attaching the root of lower rank under the other.
+
+    @param a A cell in the structure.
+    @param b Another cell in the structure.
+    @return true if they were in different sets, false otherwise.
+*/
+bool RollbackUnionFindStruct::unite(unsigned int a, unsigned int b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) {
+        return false;
+    }
+    if (m_rank->value(a) < m_rank->value(b)) {
+        unsigned int swap = a;
+        a = b;
+        b = swap;
+    }
+    bool grew = m_rank->value(a) == m_rank->value(b);
+    m_parent->value(b) = a;
+    if (grew) {
+        m_rank->value(a)++;
+    }
+    m_components--;
+    Change change = {b, a, grew};
+    m_log.push_back(change);
+    return true;
+}
+
+/**
+    Undoes every add and union made since a checkpoint, latest first.
+
+    @param checkpoint A value returned by checkpoint() since the last commit.
+*/
+void RollbackUnionFindStruct::rollback(size_t checkpoint) {
+    while (m_log.size() > checkpoint) {
+        Change change = m_log.back();
+        m_log.pop_back();
+        if (change.root == UNION_FIND_ADDED) {
+            m_parent->unmark(change.cell);
+            m_components--;
+            continue;
+        }
+        m_parent->value(change.cell) = change.cell;
+        if (change.grewRank) {
+            m_rank->value(change.root)--;
+        }
+        m_components++;
+    }
+}
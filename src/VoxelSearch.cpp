@@ -0,0 +1,297 @@
+/**
+    CS591-W1 Final Project
+    VoxelSearch.cpp
+    Purpose: For the breadth first path searches over the voxels of one label.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include "../include/VoxelSearch.h"
+
+PathMode g_pathMode = PATH_BFS;
+unsigned long long g_searchExpansions[PATH_MODE_COUNT] = {0, 0, 0};
+
+/**
+    Constructor for the VoxelSearchStruct class. Leases a cleared scratch grid for the search.
+
+    @param voxel_list A VoxelGrid representing the current state of the puzzle.
+    @param label The label of the voxels the search may pass through. Usually is 1.
+*/
+VoxelSearchStruct::VoxelSearchStruct(CompFab::VoxelGrid * voxel_list, int label) : m_visited(voxel_list->m_size), m_reached(voxel_list->m_size) {
+    m_grid = voxel_list;
+    m_label = label;
+    m_head = 0;
+    m_expanded = 0;
+    m_visited->reserveValues();
+    m_reached->reserveValues();
+}
+
+/**
+    Keeps the search out of a voxel.
+
+    @param voxel The voxel to forbid. Must be inside the grid.
+*/
+void VoxelSearchStruct::forbid(const Voxel & voxel) {
+    unsigned int index = voxelIndex(m_grid, voxel);
+    m_visited->mark(index);
+    m_visited->value(index) = VOXEL_SEARCH_FORBIDDEN;
+}
+
+/**
+    Keeps the search out of every voxel in a list.
+
+    @param voxels The voxels to forbid. Must be inside the grid.
+*/
+void VoxelSearchStruct::forbid(const std::vector<Voxel> & voxels) {
+    for (int i = 0; i < voxels.size(); i++) {
+        forbid(voxels[i]);
+    }
+}
+
+/**
+    Starts a search tree at a voxel. Forbid cells before calling this.
+
+    @param start The root of the tree. It must not be forbidden.
+*/
+void VoxelSearchStruct::root(const Voxel & start) {
+    unsigned int startIndex = voxelIndex(m_grid, start);
+    m_visited->mark(startIndex);
+    m_visited->value(startIndex) = startIndex;
+    m_reached->mark(startIndex);
+    m_reached->value(startIndex) = 0;
+    m_queue.clear();
+    m_queue.push_back(start);
+    m_head = 0;
+}
+
+/**
+    Expands the tree until a voxel is discovered or nothing more can be. The parent found for each
+    voxel is the one a search from the root that stopped at that voxel would find.
+
+    @param target The voxel to reach.
+    @return true if the target is in the tree, false if it can't be reached from the root.
+*/
+bool VoxelSearchStruct::reach(const Voxel & target) {
+    if (target.x < 0 || target.x >= (int)m_grid->m_dimX || target.y < 0 || target.y >= (int)m_grid->m_dimY
+        || target.z < 0 || target.z >= (int)m_grid->m_dimZ) {
+        return false;
+    }
+    unsigned int targetIndex = voxelIndex(m_grid, target);
+    ScratchGrid & visited = *m_visited;
+    ScratchGrid & reached = *m_reached;
+    std::vector<Voxel> & queue = m_queue;
+    while (!reached.marked(targetIndex) && m_head < m_queue.size()) {
+        Voxel current = m_queue[m_head++];
+        m_expanded++;
+        g_searchExpansions[PATH_BFS]++;
+        unsigned int index = voxelIndex(m_grid, current);
+        unsigned int nextDepth = reached.value(index) + 1;
+        forEachNeighbor(m_grid, current, m_label, [&](const Voxel & next, unsigned int nextIndex) {
+            if (visited.testAndMark(nextIndex)) {
+                visited.value(nextIndex) = index;
+                reached.mark(nextIndex);
+                reached.value(nextIndex) = nextDepth;
+                queue.push_back(next);
+            }
+        });
+    }
+    return reached.marked(targetIndex);
+}
+
+/**
+    Finds a shortest path between two voxels with the search selected by g_pathMode.
+
+    @param start The voxel the path starts from. It must not be forbidden.
+    @param goal The voxel the path ends at.
+    @return The path from start to goal, or an empty list if goal can't be reached.
+*/
+std::vector<Voxel> VoxelSearchStruct::pointPath(const Voxel & start, const Voxel & goal) {
+    if (g_pathMode == PATH_ASTAR) {
+        return aStarPath(start, goal);
+    }
+    if (g_pathMode == PATH_BIDIRECTIONAL) {
+        return bidirectionalPath(start, goal);
+    }
+    return shortestPath(start, [&](const Voxel & voxel, unsigned int index) {
+        return voxel == goal;
+    });
+}
+
+/**
+    Manhattan distance between two voxels, which never overestimates the number of unit steps.
+*/
+static inline unsigned int manhattan(const Voxel & a, const Voxel & b) {
+    return std::abs(a.x - b.x) + std::abs(a.y - b.y) + std::abs(a.z - b.z);
+}
+
+/**
+    Finds a shortest path between two voxels with A*, guided by the Manhattan distance to the goal.
+    Every step costs one, so the open set is a bucket queue indexed by estimated path length, and
+    the estimate of a cell's neighbor is either the same or two more. Within a bucket the most
+    recently added cell comes first, which follows one straight route toward the goal while the
+    way is open. The path has the same length as the breadth first one.
+
+    @param start The voxel the path starts from. It must not be forbidden.
+    @param goal The voxel the path ends at.
+    @return The path from start to goal, or an empty list if goal can't be reached.
+*/
+std::vector<Voxel> VoxelSearchStruct::aStarPath(const Voxel & start, const Voxel & goal) {
+    ScratchGrid & parent = *m_visited;
+    ScratchGrid & distance = *m_reached;
+    unsigned int startIndex = voxelIndex(m_grid, start);
+    unsigned int goalIndex = voxelIndex(m_grid, goal);
+    parent.mark(startIndex);
+    parent.value(startIndex) = startIndex;
+    distance.mark(startIndex);
+    distance.value(startIndex) = 0;
+
+    //buckets[f - minimum] holds the cells whose distance plus estimate is f
+    unsigned int minimum = manhattan(start, goal);
+    std::vector<std::vector<Voxel> > buckets(1, std::vector<Voxel>(1, start));
+    for (unsigned int f = 0; f < buckets.size(); f++) {
+        while (!buckets[f].empty()) {
+            Voxel current = buckets[f].back();
+            buckets[f].pop_back();
+            unsigned int index = voxelIndex(m_grid, current);
+            unsigned int g = distance.value(index);
+            if (g + manhattan(current, goal) != f + minimum) {
+                // Reached more cheaply since it was queued
+                continue;
+            }
+            if (index == goalIndex) {
+                return pathTo(goalIndex);
+            }
+            m_expanded++;
+            g_searchExpansions[PATH_ASTAR]++;
+            forEachNeighbor(m_grid, current, m_label, [&](const Voxel & next, unsigned int nextIndex) {
+                if (parent.marked(nextIndex) && parent.value(nextIndex) == VOXEL_SEARCH_FORBIDDEN) {
+                    return;
+                }
+                if (distance.marked(nextIndex) && distance.value(nextIndex) <= g + 1) {
+                    return;
+                }
+                parent.mark(nextIndex);
+                parent.value(nextIndex) = index;
+                distance.mark(nextIndex);
+                distance.value(nextIndex) = g + 1;
+                unsigned int bucket = g + 1 + manhattan(next, goal) - minimum;
+                if (bucket >= buckets.size()) {
+                    buckets.resize(bucket + 1);
+                }
+                buckets[bucket].push_back(next);
+            });
+        }
+    }
+    return std::vector<Voxel>();
+}
+
+/**
+    Finds a shortest path between two voxels by growing a search from each end, always extending
+    whichever frontier is smaller by one whole level, until they touch. Each side only explores
+    about half the path length, rather than everything closer to the start than the goal is.
+    The path has the same length as the one shortestPath would find, but ties between equally
+    short paths may be broken differently.
+
+    @param start The voxel the path starts from. It must not be forbidden.
+    @param goal The voxel the path ends at.
+    @return The path from start to goal, or an empty list if goal can't be reached.
+*/
+std::vector<Voxel> VoxelSearchStruct::bidirectionalPath(const Voxel & start, const Voxel & goal) {
+    ScratchGrid & forward = *m_visited;
+    ScratchGrid & backward = *m_reached;
+    unsigned int startIndex = voxelIndex(m_grid, start);
+    forward.mark(startIndex);
+    forward.value(startIndex) = startIndex;
+    if (start == goal) {
+        return pathTo(startIndex);
+    }
+    unsigned int goalIndex = voxelIndex(m_grid, goal);
+    if ((int)m_grid->m_insideArray[goalIndex] != m_label || forward.marked(goalIndex)) {
+        return std::vector<Voxel>();
+    }
+    backward.mark(goalIndex);
+    backward.value(goalIndex) = goalIndex;
+
+    std::vector<Voxel> forwardLevel(1, start);
+    std::vector<Voxel> backwardLevel(1, goal);
+    std::vector<Voxel> next;
+    bool met = false;
+    unsigned int meet = 0;
+    while (!met && !forwardLevel.empty() && !backwardLevel.empty()) {
+        bool fromStart = forwardLevel.size() <= backwardLevel.size();
+        ScratchGrid & own = fromStart ? forward : backward;
+        ScratchGrid & other = fromStart ? backward : forward;
+        std::vector<Voxel> & level = fromStart ? forwardLevel : backwardLevel;
+        next.clear();
+        for (int i = 0; i < level.size() && !met; i++) {
+            unsigned int index = voxelIndex(m_grid, level[i]);
+            m_expanded++;
+            g_searchExpansions[PATH_BIDIRECTIONAL]++;
+            forEachNeighbor(m_grid, level[i], m_label, [&](const Voxel & voxel, unsigned int nextIndex) {
+                if (met || own.marked(nextIndex) || (forward.marked(nextIndex) && forward.value(nextIndex) == VOXEL_SEARCH_FORBIDDEN)) {
+                    return;
+                }
+                own.mark(nextIndex);
+                own.value(nextIndex) = index;
+                next.push_back(voxel);
+                if (other.marked(nextIndex)) {
+                    met = true;
+                    meet = nextIndex;
+                }
+            });
+        }
+        level.swap(next);
+    }
+    if (!met) {
+        return std::vector<Voxel>();
+    }
+    std::vector<Voxel> path = pathTo(meet);
+    for (unsigned int index = meet; backward.value(index) != index; ) {
+        index = backward.value(index);
+        path.push_back(voxelAt(m_grid, index));
+    }
+    return path;
+}
+
+/**
+    The number of steps from the root to a voxel already in the tree.
+
+    @param voxel A voxel for which reach returned true.
+    @return Its distance from the root.
+*/
+unsigned int VoxelSearchStruct::depth(const Voxel & voxel) {
+    return m_reached->value(voxelIndex(m_grid, voxel));
+}
+
+/**
+    Rebuilds the path to a voxel already in the tree.
+
+    @param voxel A voxel for which reach returned true.
+    @return The path from the root to that voxel.
+*/
+std::vector<Voxel> VoxelSearchStruct::pathTo(const Voxel & voxel) {
+    return pathTo(voxelIndex(m_grid, voxel));
+}
+
+/**
+    Rebuilds the path to a reached cell by following parents back to the start.
+
+    @param index The linear index of a cell reached by the last search.
+    @return The path from the start of the search to that cell.
+*/
+std::vector<Voxel> VoxelSearchStruct::pathTo(unsigned int index) {
+    std::vector<Voxel> path;
+    while (true) {
+        path.push_back(voxelAt(m_grid, index));
+        unsigned int parent = m_visited->value(index);
+        if (parent == index) {
+            break;
+        }
+        index = parent;
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
@@ -0,0 +1,154 @@
+/**
+    CS591-W1 Final Project
+    WeightSampler.cpp
+    Purpose: For drawing weighted random choices from a changing set of slots.
+
+    @author Ben Gaudiosi
+    @version 1.0 5/01/2018
+*/
+#include <vector>
+#include "../include/WeightSampler.h"
+
+/**
+    Clamps a weight into [0, WEIGHT_SAMPLER_MAX].
+
+    @param weight The weight.
+    @return 0 for NaN or a negative weight, WEIGHT_SAMPLER_MAX for anything larger, else the weight.
+*/
+static inline double clampWeight(double weight) {
+    if (!(weight > 0)) {
+        return 0;
+    }
+    return weight < WEIGHT_SAMPLER_MAX ? weight : WEIGHT_SAMPLER_MAX;
+}
+
+/**
+    Constructor for the WeightSamplerStruct class. Starts with no slots.
+*/
+WeightSamplerStruct::WeightSamplerStruct() {
+    m_tree.assign(1, 0.0);
+    m_changes = 0;
+}
+
+/**
+    Removes every slot.
+*/
+void WeightSamplerStruct::clear() {
+    m_weights.clear();
+    m_tree.assign(1, 0.0);
+    m_changes = 0;
+}
+
+/**
+    Replaces every slot with one per weight, in O(n).
+
+    @param weights The weights of slots 0, 1, ..., clamped as described in WeightSampler.h.
+*/
+void WeightSamplerStruct::assign(const std::vector<double> & weights) {
+    m_weights.resize(weights.size());
+    for (unsigned int i = 0; i < weights.size(); i++) {
+        m_weights[i] = clampWeight(weights[i]);
+    }
+    rebuild();
+}
+
+/**
+    Builds the tree from the weights, in O(n).
+*/
+void WeightSamplerStruct::rebuild() {
+    unsigned int n = m_weights.size();
+    m_tree.assign(n + 1, 0.0);
+    for (unsigned int i = 1; i <= n; i++) {
+        m_tree[i] += m_weights[i - 1];
+        unsigned int up = i + (i & -i);
+        if (up <= n) {
+            m_tree[up] += m_tree[i];
+        }
+    }
+    m_changes = 0;
+}
+
+/**
+    Adds a slot after the last one.
+
+    @param weight Its weight, clamped as described in WeightSampler.h.
+    @return The number of the new slot.
+*/
+unsigned int WeightSamplerStruct::add(double weight) {
+    weight = clampWeight(weight);
+    unsigned int slot = m_weights.size();
+    unsigned int i = slot + 1;
+    m_weights.push_back(weight);
+    // Entry i covers slots i - (i & -i) through i - 1
+    m_tree.push_back(weight + prefix(slot) - prefix(i - (i & -i)));
+    return slot;
+}
+
+/**
+    Changes the weight of a slot.
+
+    @param slot The slot.
+    @param weight Its new weight, or 0 to remove it, clamped as described in WeightSampler.h.
+*/
+void WeightSamplerStruct::set(unsigned int slot, double weight) {
+    weight = clampWeight(weight);
+    bool offCap = m_weights[slot] == WEIGHT_SAMPLER_MAX && weight != WEIGHT_SAMPLER_MAX;
+    double delta = weight - m_weights[slot];
+    m_weights[slot] = weight;
+    if (++m_changes > m_weights.size() || offCap) {
+        rebuild();
+        return;
+    }
+    for (unsigned int i = slot + 1; i < m_tree.size(); i += i & -i) {
+        m_tree[i] += delta;
+    }
+}
+
+/**
+    The sum of the weights of the first slots.
+
+    @param slots The number of slots to sum.
+    @return Their total weight.
+*/
+double WeightSamplerStruct::prefix(unsigned int slots) const {
+    double sum = 0;
+    for (unsigned int i = slots; i > 0; i -= i & -i) {
+        sum += m_tree[i];
+    }
+    return sum;
+}
+
+/**
+    Draws a slot with probability proportional to its weight: the first slot whose running total
+    exceeds random times the total weight, as a scan of the slots in order would find.
+
+    @param random A uniform random number in [0, 1].
+    @return The slot drawn, or -1 if every weight is 0.
+*/
+int WeightSamplerStruct::draw(double random) const {
+    unsigned int n = m_weights.size();
+    double target = random * total();
+    unsigned int step = 1;
+    while (2*step <= n) {
+        step *= 2;
+    }
+    unsigned int found = 0;
+    for (; step > 0; step /= 2) {
+        if (found + step <= n && m_tree[found + step] <= target) {
+            found += step;
+            target -= m_tree[found];
+        }
+    }
+    // Rounding can land past the end or on a removed slot; take the nearest live one
+    for (int slot = found < n ? found : n - 1; slot >= 0; slot--) {
+        if (m_weights[slot] > 0) {
+            return slot;
+        }
+    }
+    for (unsigned int slot = found; slot < n; slot++) {
+        if (m_weights[slot] > 0) {
+            return slot;
+        }
+    }
+    return -1;
+}
@@ -20,20 +20,36 @@
 #include "../include/Voxelize.h"
 #include "../include/voxelparse.h"
 #include "../include/ExtractPartitions.h"
+#include "../include/GridSnapshot.h"
+#include "../include/GridTransaction.h"
+#include "../include/AccessibilityEngine.h"
+#include "../include/AccessibilityScorer.h"
 
 int main(int argc, char **argv)
 {
     //fix later
     if(argc < 4)
     {
-        std::cout<<"Usage: puzzle InputMeshFilename OutputMeshFilename Dim NumPieces\n";
+        std::cout<<"Usage: puzzle InputMeshFilename OutputMeshFilename Dim NumPieces [SnapshotFilename]\n";
         exit(0);
     }
     
     int dim = atoi(argv[3]); //dimension of voxel grid (e.g. 32x32x32)
     std::string filename(argv[2]);
 
-    CompFab::VoxelGrid * voxel_list = objToVoxelGrid(argv[1], dim);
+    // A snapshot input skips voxelization and scoring; edits stay private to this process
+    GridSnapshot * snapshot = NULL;
+    CompFab::VoxelGrid * voxel_list;
+    if (isGridSnapshot(argv[1])) {
+        snapshot = mapGridSnapshot(argv[1]);
+        if (snapshot == NULL) {
+            exit(0);
+        }
+        voxel_list = snapshot->m_grid;
+        dim = voxel_list->m_dimX;
+    } else {
+        voxel_list = objToVoxelGrid(argv[1], dim);
+    }
     /*
     CompFab::Vec3 start = CompFab::Vec3(0.0, 0.0, 0.0);
     CompFab::VoxelGrid * voxel_list = new CompFab::VoxelGrid(start, dim, dim, dim, 1.0);
@@ -61,7 +77,18 @@ int main(int argc, char **argv)
     int num_pieces = atoi(argv[4]);
     int m = num_voxels/ num_pieces;
 
-    AccessibilityGrid * scores = accessibilityScores(voxel_list, 0.1, 3, 1);
+    AccessibilityGrid * scores;
+    if (snapshot != NULL && snapshot->m_scores != NULL) {
+        scores = snapshot->m_scores;
+    } else {
+        scores = currentAccessibility(voxel_list, 0.1, 3, 1);
+    }
+    if (argc > 5) {
+        saveGridSnapshot(argv[5], voxel_list, scores);
+    }
+    buildRayIndex(voxel_list);
+    buildRemainderOracle(voxel_list);
+    buildScorePrefix(voxel_list, scores);
     std::vector<Voxel> seeds = findSeeds(voxel_list);
     
     int seed_choice;
@@ -70,8 +97,8 @@ int main(int argc, char **argv)
     Voxel prevNormal(0,0,1);
     std::vector<Voxel> anchors;
     std::vector<VoxelPair> interlock;
-    std::vector<Voxel> key;
-    std::vector<Voxel> testKey;
+    Piece key;
+    Piece testKey;
     int blocker;
     bool okay;
     int expand = m;
@@ -101,18 +128,18 @@ int main(int argc, char **argv)
     }
 
     for (int i = 0; i < key.size(); i ++) {
-        voxel_list->isInside(key[i].x, key[i].y, key[i].z) = 2;
+        setVoxelLabel(voxel_list, key[i], 2);
     }
     
     std::cout<< "Key is " << std::endl;
     printList(key);
     
     std::vector<Voxel> candidates;
-    std::vector<Voxel> prevPiece = key;
-    std::vector<Voxel> nextPiece;
+    Piece prevPiece = key;
+    Piece nextPiece;
     Voxel nextNormal;
     std::vector<Voxel> anchorList;
-    std::vector<Voxel> testPiece;
+    Piece testPiece;
     int voxels_left = num_voxels;
     std::vector<Voxel> normal_list;
     normal_list.push_back(prevNormal);
@@ -133,7 +160,8 @@ int main(int argc, char **argv)
     for (int i = 0; i < iterations; i++) {
         p = i+3;
         std::cout << "On piece " << std::to_string(p-1) << std::endl;
-        scores = accessibilityScores(voxel_list, 0.1, 3, 1);
+        scores = currentAccessibility(voxel_list, 0.1, 3, 1);
+        buildScorePrefix(voxel_list, scores);
         candidates = findCandidateSeeds(voxel_list, scores, prevPiece, prevNormal);
         nextPiece.clear();
         while (nextPiece.size() < (int)(0.75*m) ) {
@@ -155,9 +183,11 @@ int main(int argc, char **argv)
             printList(nextPiece);
             */
             nextPiece = ensurePieceConnectivity(voxel_list, nextPiece, nextNormal);
+            // Labelled on trial; undone below if the piece can't grow big enough
+            GridTransaction trial(voxel_list);
             for (int i = 0; i < nextPiece.size(); i++) {
                 std::cout << "piece " << std::to_string(p-1) << " " << nextPiece[i].toString() << std::endl;
-                voxel_list->isInside(nextPiece[i].x, nextPiece[i].y, nextPiece[i].z) = p;
+                trial.relabel(nextPiece[i], p);
             }
             okay = false;
             expand = m;
@@ -175,14 +205,14 @@ int main(int argc, char **argv)
                 candidates.erase (candidates.begin()+index);
                 for (int i = 0; i < nextPiece.size(); i++) {
                     std::cout << "piece " << std::to_string(p-1) << " " << nextPiece[i].toString() << std::endl;
-                    voxel_list->isInside(nextPiece[i].x, nextPiece[i].y, nextPiece[i].z) = 1;
                 }
+                trial.rollback();
             }
         }
 
         for (int i = 0; i < nextPiece.size(); i++) {
             //std::cout << "upon expansion, piece " << std::to_string(p-1) << " is now " << nextPiece[i].toString() << std::endl;
-            voxel_list->isInside(nextPiece[i].x, nextPiece[i].y, nextPiece[i].z) = p;
+            setVoxelLabel(voxel_list, nextPiece[i], p);
         }
         std::cout << "Piece " << std::to_string(p-1) << " successfully made!" << std::endl;
         std::cout << "Piece is: " << std::endl;
@@ -196,29 +226,32 @@ int main(int argc, char **argv)
     generateObj(old, voxel_list, 10, 5.0);
     
     // so now, we have no piece = 1, key = 2, piece_2 = 3, piece_3 = 4
-    std::vector<Voxel> piece;
-    AccessibilityGrid * pieceScore;
-    std::vector<Voxel> partition;
+    Piece partition;
     if (!recurse) {
-        for (int p = 3; p < num_pieces; p++) {
-            piece.clear();
-            // First, find all the voxels that belong to this piece
-            for (int i = 0; i < dim; i++) {
-                for (int j = 0; j < dim; j++) {
-                    for (int k = 0; k < dim; k++) {
-                        if (voxel_list->isInside(i,j,k) == p) {
-                            piece.push_back(Voxel(i,j,k));
-                        }
+        // Partitioning a piece only relabels its own voxels, to ids above every piece still
+        // waiting, so each piece's voxels and scores are found for all of them up front
+        std::vector<Piece> pieces(num_pieces);
+        for (int i = 0; i < dim; i++) {
+            for (int j = 0; j < dim; j++) {
+                for (int k = 0; k < dim; k++) {
+                    int label = voxel_list->isInside(i,j,k);
+                    if (label >= 3 && label < num_pieces) {
+                        pieces[label].insert(Voxel(i,j,k));
                     }
                 }
             }
-            pieceScore = accessibilityScores(voxel_list, 0.1, 3, p);
+        }
+        AccessibilityGrid pieceScores(CompFab::Vec3(0.0, 0.0, 0.0), voxel_list->m_dimX, voxel_list->m_dimY, voxel_list->m_dimZ);
+        AccessibilityScorer scorer;
+        scorer.scoreOwnLabels(voxel_list, 0.1, 3, pieceScores.m_scoreArray);
+        for (int p = 3; p < num_pieces; p++) {
+            const Piece & piece = pieces[p];
             // Then, grow from said piece. If adding a voxel disconnects the piece, don't add it.
-            partition = partitionPiece(voxel_list, pieceScore, piece,p, (int) m / 2 );
+            partition = partitionPiece(voxel_list, &pieceScores, piece,p, (int) m / 2 );
             std::cout << "parition.size is " << std::to_string(partition.size()) << std::endl;
             std::cout << "piece.size is " << std::to_string(piece.size()) << std::endl;
             for (int i = 0; i < partition.size(); i++) {
-                voxel_list->isInside(partition[i].x, partition[i].y, partition[i].z) = num_pieces + p - 1;
+                setVoxelLabel(voxel_list, partition[i], num_pieces + p - 1);
             }
         }
     }